@@ -0,0 +1,339 @@
+// Engine microbenchmark suite:
+// Times the hot primitives of the engine and the game (headless, single threaded, on fixed generated inputs):
+// Line drawing variants, curves, edge culling/clipping, canvas clearing and resolving, text, ball simulation
+// and mesh serialization. Prints one machine-readable line per case, with the time per operation
+// and the throughput of the case's items (lines, curve segments, edges, pixels, characters, updates or bytes).
+
+#define SLIM_ENGINE_NO_MAIN
+#include "../SlimEngine/app.h"
+#include "../SlimEngine/draw/line.h"
+#include "../SlimEngine/draw/curve.h"
+#include "../SlimEngine/draw/text.h"
+#include "../SlimEngine/serialization/mesh.h"
+#include "../GameLib/ball_controller.hpp"
+
+#define ENGINE_BENCHMARK_MIN_SECONDS 0.25
+#define ENGINE_BENCHMARK_WIDTH 1920
+#define ENGINE_BENCHMARK_HEIGHT 1080
+#define ENGINE_BENCHMARK_LINE_COUNT 4096
+#define ENGINE_BENCHMARK_EDGE_COUNT 65536
+#define ENGINE_BENCHMARK_CURVE_COUNT 64
+#define ENGINE_BENCHMARK_TEXT_COUNT 64
+#define ENGINE_BENCHMARK_UPDATE_COUNT 2400
+#define ENGINE_BENCHMARK_MESH_GRID_SIZE 128
+#define ENGINE_BENCHMARK_MESH_FILE "/tmp/EngineBenchmark.mesh"
+
+typedef void (*BenchmarkOperation)();
+
+// Runs the operation repeatedly for at least the minimum time, returning the nanoseconds per run:
+f64 measure(BenchmarkOperation operation, u32 *iterations) {
+    u32 count = 0;
+    u64 start_ticks = time::getTicks();
+    u64 end_ticks = start_ticks;
+    while ((f64)(end_ticks - start_ticks) * time::seconds_per_tick < ENGINE_BENCHMARK_MIN_SECONDS) {
+        operation();
+        count++;
+        end_ticks = time::getTicks();
+    }
+    *iterations = count;
+    return (f64)(end_ticks - start_ticks) * time::nanoseconds_per_tick / (f64)count;
+}
+
+// Each run performs op_count operations, processing item_count items in total:
+void run(const char *name, const char *variant, BenchmarkOperation operation, u32 op_count, u64 item_count) {
+    u32 iterations;
+    f64 nanoseconds = measure(operation, &iterations);
+    printf("engine benchmark=%s variant=%s ops=%u items=%llu iterations=%u ns_per_op=%.1f items_per_second=%.0f\n",
+           name, variant, op_count, (unsigned long long)item_count, iterations,
+           nanoseconds / (f64)op_count, (f64)item_count * 1000000000.0 / nanoseconds);
+}
+
+u32 random_state = 0x12345678u;
+INLINE f32 randomUnit() {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return (f32)(random_state >> 8) * (1.0f / (f32)(1 << 24));
+}
+
+Canvas &canvas{window::canvas}; // Resolved by renderCanvasToContent
+Camera camera{{0, 15, -100}, {15 * DEG_TO_RAD, 0, 0}};
+Viewport *viewport;
+
+// Lines:
+struct BenchmarkLine {
+    f32 x1, y1, x2, y2;
+    f64 z1, z2;
+    vec3 color;
+};
+BenchmarkLine lines[ENGINE_BENCHMARK_LINE_COUNT];
+bool lines_have_depth;
+
+// Short to medium segments within the viewport, mostly along the major axis (shallow: x, steep: y):
+void generateLines(bool steep) {
+    for (BenchmarkLine &line : lines) {
+        f32 major = 8 + randomUnit() * 120;
+        f32 minor = (randomUnit() - 0.5f) * major;
+        f32 dx = steep ? minor : major;
+        f32 dy = steep ? major : minor;
+        line.x1 = 1 + randomUnit() * (ENGINE_BENCHMARK_WIDTH  - 130);
+        line.y1 = 1 + randomUnit() * (ENGINE_BENCHMARK_HEIGHT - 130);
+        if (randomUnit() < 0.5f) dx = -dx;
+        if (dx < 0) line.x1 -= dx;
+        line.x2 = line.x1 + dx;
+        line.y2 = line.y1 + dy;
+        line.z1 = 2 + randomUnit() * 20;
+        line.z2 = 2 + randomUnit() * 20;
+        line.color = vec3{randomUnit(), randomUnit(), randomUnit()};
+    }
+}
+
+void drawLines() {
+    for (BenchmarkLine &line : lines)
+        drawLine(line.x1, line.y1, lines_have_depth ? line.z1 : 0,
+                 line.x2, line.y2, lines_have_depth ? line.z2 : 0,
+                 *viewport, line.color, 1, 1);
+}
+
+// Curves:
+Curve helix{CurveType::Helix, 10};
+Transform curve_transforms[ENGINE_BENCHMARK_CURVE_COUNT];
+vec3 curve_colors[ENGINE_BENCHMARK_CURVE_COUNT];
+
+// A grid of brick-like helices in front of the camera:
+void generateCurves() {
+    for (u32 i = 0; i < ENGINE_BENCHMARK_CURVE_COUNT; i++) {
+        Transform &transform = curve_transforms[i];
+        transform.position.x = -70.0f + 20.0f * (f32)(i % 8);
+        transform.position.y = -10.0f + 8.0f * (f32)(i / 8);
+        transform.scale.x = 8;
+        curve_colors[i] = vec3{randomUnit(), randomUnit(), randomUnit()};
+    }
+}
+
+void drawCurves() {
+    for (u32 i = 0; i < ENGINE_BENCHMARK_CURVE_COUNT; i++)
+        draw(helix, curve_transforms[i], *viewport, curve_colors[i], 1, 1);
+}
+
+void drawCurveInstances() {
+    draw(helix, curve_transforms, ENGINE_BENCHMARK_CURVE_COUNT, *viewport, curve_colors, Color(White), 1, 1);
+}
+
+// Edges (in view space, a third of them crossing the near clipping plane or outside the frustum):
+Edge edges[ENGINE_BENCHMARK_EDGE_COUNT];
+u32 visible_edge_count;
+
+void generateEdges() {
+    for (Edge &edge : edges) {
+        edge.from = vec3{(randomUnit() - 0.5f) * 60, (randomUnit() - 0.5f) * 40, -10 + randomUnit() * 60};
+        edge.to = edge.from + vec3{(randomUnit() - 0.5f) * 20, (randomUnit() - 0.5f) * 20, (randomUnit() - 0.5f) * 20};
+    }
+}
+
+void cullAndClipEdges() {
+    u32 count = 0;
+    for (const Edge &original : edges) {
+        Edge edge = original;
+        if (viewport->cullAndClipEdge(edge)) count++;
+    }
+    visible_edge_count = count;
+}
+
+// Canvas clearing and resolving:
+u32 *content;
+
+void clearFull() {
+    canvas.markDrawnPixels(0, canvas.dimensions.width, 0, canvas.dimensions.height);
+    canvas.clear();
+}
+
+void clearEmpty() {
+    canvas.clear();
+}
+
+void resolveFull() {
+    window::renderCanvasToContent();
+}
+
+// Text:
+char text[] = "Lives : 3  Bricks: 17  Score: 1234";
+
+void drawTexts() {
+    for (u32 i = 0; i < ENGINE_BENCHMARK_TEXT_COUNT; i++)
+        drawText(text, 10 + (i32)(i % 4) * 440, 10 + (i32)(i / 4) * 60, *viewport, Color(BrightGreen), 1);
+}
+
+void drawCachedTexts() {
+    for (u32 i = 0; i < ENGINE_BENCHMARK_TEXT_COUNT; i++)
+        drawCachedText(text, 10 + (i32)(i % 4) * 440, 10 + (i32)(i / 4) * 60, *viewport, Color(BrightGreen), 1);
+}
+
+// Ball simulation, in a level filled with bricks of every kind (the paddle follows the ball to keep it in play):
+char full_map[] = ""
+                  "#=-=#" "\n"
+                  "-~-~-" "\n"
+                  "=-=-=" "\n"
+                  "-~-~-" "\n"
+                  "=-#-=";
+Level level{full_map};
+Ball ball;
+Paddle paddle;
+BallController ball_controller{ball};
+
+void simulateBall() {
+    level.reset();
+    ball_controller.reset();
+    for (u32 i = 0; i < ENGINE_BENCHMARK_UPDATE_COUNT; i++) {
+        paddle.position.x = ball.position.x;
+        paddle.updateRect();
+        ball_controller.update(1.0f / 240.0f, level.scale, paddle, level);
+        if (ball.position.y < -10) ball_controller.reset();
+    }
+}
+
+void updateMovingBricks() {
+    for (u32 i = 0; i < ENGINE_BENCHMARK_UPDATE_COUNT; i++)
+        level.updateMovingBricks(1.0f / 240.0f);
+}
+
+// Mesh serialization (a grid of vertices, with 2 triangles and 3 edges per cell):
+Mesh mesh;
+Mesh loaded_mesh;
+memory::MonotonicAllocator mesh_memory;
+u8 *mesh_memory_address;
+
+void generateMesh() {
+    const u32 size = ENGINE_BENCHMARK_MESH_GRID_SIZE;
+    const u32 cell_count = (size - 1) * (size - 1);
+    mesh.vertex_count = size * size;
+    mesh.triangle_count = cell_count * 2;
+    mesh.edge_count = cell_count * 3;
+    mesh.vertex_positions = new vec3[mesh.vertex_count];
+    mesh.vertex_position_indices = new TriangleVertexIndices[mesh.triangle_count];
+    mesh.edge_vertex_indices = new EdgeVertexIndices[mesh.edge_count];
+    for (u32 y = 0; y < size; y++)
+        for (u32 x = 0; x < size; x++)
+            mesh.vertex_positions[y * size + x] = vec3{(f32)x, randomUnit(), (f32)y};
+
+    TriangleVertexIndices *triangle = mesh.vertex_position_indices;
+    EdgeVertexIndices *edge = mesh.edge_vertex_indices;
+    for (u32 y = 0; y < size - 1; y++)
+        for (u32 x = 0; x < size - 1; x++) {
+            u32 i = y * size + x;
+            triangle->ids[0] = i;
+            triangle->ids[1] = i + size;
+            triangle->ids[2] = i + 1;
+            triangle++;
+            triangle->ids[0] = i + 1;
+            triangle->ids[1] = i + size;
+            triangle->ids[2] = i + size + 1;
+            triangle++;
+            edge->from = i; edge->to = i + 1;        edge++;
+            edge->from = i; edge->to = i + size;     edge++;
+            edge->from = i + 1; edge->to = i + size; edge++;
+        }
+    mesh.aabb.min = vec3{0, 0, 0};
+    mesh.aabb.max = vec3{(f32)size, 1, (f32)size};
+
+    mesh_memory = memory::MonotonicAllocator{getSizeInBytes(mesh)};
+    mesh_memory_address = mesh_memory.address;
+}
+
+void saveMesh() {
+    save(mesh, (char*)ENGINE_BENCHMARK_MESH_FILE);
+}
+
+void loadMesh() {
+    mesh_memory.address = mesh_memory_address;
+    mesh_memory.occupied = 0;
+    load(loaded_mesh, (char*)ENGINE_BENCHMARK_MESH_FILE, &mesh_memory);
+}
+
+int main(int argc, char **argv) {
+    if (argc != 1) {
+        printf("Usage: %s\n", argv[0]);
+        return -1;
+    }
+    initTime();
+    workers::setThreadCount(1);
+
+    void *memory = os::getMemory(CANVAS_SIZE + WINDOW_CONTENT_SIZE);
+    if (!memory) {
+        printf("Failed to allocate memory\n");
+        return -1;
+    }
+    window::content = content = (u32*)memory;
+    canvas.pixels = (PixelQuad*)((u8*)memory + WINDOW_CONTENT_SIZE);
+    canvas.dimensions.update(ENGINE_BENCHMARK_WIDTH, ENGINE_BENCHMARK_HEIGHT);
+    Viewport benchmark_viewport{canvas, &camera};
+    benchmark_viewport.updateDimensions(ENGINE_BENCHMARK_WIDTH, ENGINE_BENCHMARK_HEIGHT);
+    viewport = &benchmark_viewport;
+    const u32 pixel_count = (u32)ENGINE_BENCHMARK_WIDTH * ENGINE_BENCHMARK_HEIGHT;
+
+    // drawLine: shallow/steep, aliased/antialiased, with/without depth
+    char variant[64];
+    for (u8 steep = 0; steep < 2; steep++) {
+        generateLines(steep);
+        for (u8 aa = 0; aa < 2; aa++)
+            for (u8 depth = 0; depth < 2; depth++) {
+                canvas.antialias = aa != 0;
+                benchmark_viewport.updateDimensions(ENGINE_BENCHMARK_WIDTH, ENGINE_BENCHMARK_HEIGHT);
+                lines_have_depth = depth != 0;
+                canvas.clear();
+                sprintf(variant, "%s_%s_%s", steep ? "steep" : "shallow", aa ? "aa" : "aliased", depth ? "depth" : "flat");
+                run("drawLine", variant, drawLines, ENGINE_BENCHMARK_LINE_COUNT, ENGINE_BENCHMARK_LINE_COUNT);
+            }
+    }
+    canvas.antialias = false;
+    benchmark_viewport.updateDimensions(ENGINE_BENCHMARK_WIDTH, ENGINE_BENCHMARK_HEIGHT);
+
+    // draw(Curve): each curve is drawn as CURVE_STEPS segments
+    generateCurves();
+    canvas.clear();
+    run("drawCurve", "single", drawCurves, ENGINE_BENCHMARK_CURVE_COUNT, (u64)ENGINE_BENCHMARK_CURVE_COUNT * CURVE_STEPS);
+    canvas.clear();
+    run("drawCurve", "instanced", drawCurveInstances, ENGINE_BENCHMARK_CURVE_COUNT, (u64)ENGINE_BENCHMARK_CURVE_COUNT * CURVE_STEPS);
+
+    // Frustum::cullAndClipEdge
+    generateEdges();
+    run("cullAndClipEdge", "perspective", cullAndClipEdges, ENGINE_BENCHMARK_EDGE_COUNT, ENGINE_BENCHMARK_EDGE_COUNT);
+
+    // Canvas::clear and renderCanvasToContent
+    const char *storage_names[] = {"quads", "planes"};
+    CanvasStorage storages[] = {CanvasStorage::PixelQuads, CanvasStorage::Planes};
+    for (u8 s = 0; s < 2; s++) {
+        canvas.setStorage(storages[s]);
+        canvas.clear();
+        sprintf(variant, "%s_full", storage_names[s]);
+        run("Canvas::clear", variant, clearFull, 1, pixel_count);
+        sprintf(variant, "%s_empty", storage_names[s]);
+        run("Canvas::clear", variant, clearEmpty, 1, pixel_count);
+
+        sprintf(variant, "%s_full", storage_names[s]);
+
+        canvas.markDrawnPixels(0, ENGINE_BENCHMARK_WIDTH, 0, ENGINE_BENCHMARK_HEIGHT);
+        run("renderCanvasToContent", variant, resolveFull, 1, pixel_count);
+    }
+    canvas.setStorage(CanvasStorage::PixelQuads);
+
+    // drawText: each item is a character
+    u64 character_count = (u64)ENGINE_BENCHMARK_TEXT_COUNT * (sizeof(text) - 1);
+    canvas.clear();
+    run("drawText", "direct", drawTexts, ENGINE_BENCHMARK_TEXT_COUNT, character_count);
+    canvas.clear();
+    run("drawText", "cached", drawCachedTexts, ENGINE_BENCHMARK_TEXT_COUNT, character_count);
+
+    // BallController::update and Level::updateMovingBricks with a full level: each item is a simulation step
+    run("BallController::update", "full_level", simulateBall, ENGINE_BENCHMARK_UPDATE_COUNT, ENGINE_BENCHMARK_UPDATE_COUNT);
+    level.reset();
+    run("Level::updateMovingBricks", "full_level", updateMovingBricks, ENGINE_BENCHMARK_UPDATE_COUNT, ENGINE_BENCHMARK_UPDATE_COUNT);
+
+    // Mesh save/load: each item is a byte of mesh data
+    generateMesh();
+    u64 mesh_size = getSizeInBytes(mesh);
+    run("Mesh::save", "grid", saveMesh, 1, mesh_size);
+    run("Mesh::load", "grid", loadMesh, 1, mesh_size);
+
+    return 0;
+}
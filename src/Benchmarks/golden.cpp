@@ -0,0 +1,259 @@
+// Golden image harness:
+// Renders fixed WireBreakout scenes headlessly (the start menu, the game view after a scripted few seconds of play,
+// the paused perspective view and a wire-frame mesh scene), dumps each one's window content to a PPM file
+// and compares it against a stored reference, pixel by pixel within a per-channel tolerance.
+// Each scene is also rendered repeatedly and timed (clear, render and resolve), so a change to the renderer
+// is reported with both its correctness diff and its speed delta. Prints one machine-readable line per scene.
+// Each canvas storage has its own references (the planes storage blends a few edge pixels differently),
+// with --planes selecting the "<scene>_planes.ppm" ones. With --update the references get (re)written
+// from the current renderer instead.
+
+#define SLIM_ENGINE_NO_MAIN
+#include "../WireBreakout.cpp"
+#include "../SlimEngine/draw/mesh.h"
+
+#define GOLDEN_WIDTH 640
+#define GOLDEN_HEIGHT 480
+#define GOLDEN_DEFAULT__TOLERANCE 2
+#define GOLDEN_DEFAULT__REPETITIONS 20
+#define GOLDEN_SIMULATION_STEPS 480
+#ifndef GOLDEN_DEFAULT__REFERENCE_DIRECTORY
+#define GOLDEN_DEFAULT__REFERENCE_DIRECTORY "."
+#endif
+
+WireBreakout *game;
+
+// Mesh scene (a torus of quads, drawn as edges in perspective):
+#define GOLDEN_TORUS_RINGS 24
+#define GOLDEN_TORUS_SIDES 12
+
+vec3 torus_positions[GOLDEN_TORUS_RINGS * GOLDEN_TORUS_SIDES];
+EdgeVertexIndices torus_edges[GOLDEN_TORUS_RINGS * GOLDEN_TORUS_SIDES * 2];
+Mesh torus;
+Camera mesh_camera{{0, 12, -40}, {-20 * DEG_TO_RAD, 0, 0}};
+Viewport mesh_viewport{window::canvas, &mesh_camera};
+Transform torus_transform;
+
+void generateTorus() {
+    for (u32 ring = 0; ring < GOLDEN_TORUS_RINGS; ring++)
+        for (u32 side = 0; side < GOLDEN_TORUS_SIDES; side++) {
+            f32 u = (f32)ring / (f32)GOLDEN_TORUS_RINGS * TAU;
+            f32 v = (f32)side / (f32)GOLDEN_TORUS_SIDES * TAU;
+            f32 radius = 10 + 4 * cosf(v);
+            u32 i = ring * GOLDEN_TORUS_SIDES + side;
+            torus_positions[i] = vec3{radius * cosf(u), 4 * sinf(v), radius * sinf(u)};
+            torus_edges[i * 2    ] = {i, ((ring + 1) % GOLDEN_TORUS_RINGS) * GOLDEN_TORUS_SIDES + side};
+            torus_edges[i * 2 + 1] = {i, ring * GOLDEN_TORUS_SIDES + (side + 1) % GOLDEN_TORUS_SIDES};
+        }
+    torus.vertex_positions = torus_positions;
+    torus.vertex_count = GOLDEN_TORUS_RINGS * GOLDEN_TORUS_SIDES;
+    torus.edge_vertex_indices = torus_edges;
+    torus.edge_count = GOLDEN_TORUS_RINGS * GOLDEN_TORUS_SIDES * 2;
+    torus_transform.rotation.setRotationAroundZ(15 * DEG_TO_RAD);
+}
+
+void renderGame() {
+    game->OnRender();
+}
+
+void renderMesh() {
+    draw(torus, torus_transform, false, mesh_viewport, Color(BrightCyan), 0.75f, 1);
+}
+
+// Scene setups run in order (each one continues from the state the previous left the game in):
+void setupMenu() {}
+
+void setupGame() {
+    // Click the start button (as laid out by the last rendered menu), then launch the ball and play:
+    GameUI::Button &start = game->game.current_menu->start_button;
+    mouse::pos_x = (start.rect.left + start.rect.right) / 2;
+    mouse::pos_y = (start.rect.top + start.rect.bottom) / 2;
+    game->OnMouseButtonDown(mouse::left_button);
+    game->OnUpdate(game->update_timer.fixed_delta_time);
+    game->OnKeyChanged((u8)'W', true);
+    game->OnKeyChanged((u8)'W', false);
+    for (u32 step = 0; step < GOLDEN_SIMULATION_STEPS; step++)
+        game->OnUpdate(game->update_timer.fixed_delta_time);
+    game->update_timer.interpolation_factor = 1;
+}
+
+void setupPaused() {
+    game->OnKeyChanged(controls::key_map::space, true);
+    game->OnKeyChanged(controls::key_map::space, false);
+}
+
+void setupMesh() {}
+
+struct GoldenScene {
+    const char *name;
+    void (*setup)();
+    void (*render)();
+};
+
+GoldenScene scenes[] = {
+    {"menu",   setupMenu,   renderGame},
+    {"game",   setupGame,   renderGame},
+    {"paused", setupPaused, renderGame},
+    {"mesh",   setupMesh,   renderMesh}
+};
+
+void renderFrame(const GoldenScene &scene) {
+    window::canvas.clear();
+    scene.render();
+    window::renderCanvasToContent();
+}
+
+// Binary PPM of the window content:
+bool writeImage(const char *path, const u32 *pixels, u32 width, u32 height) {
+    FILE *file = fopen(path, "wb");
+    if (!file) return false;
+    fprintf(file, "P6\n%u %u\n255\n", width, height);
+    u8 rgb[GOLDEN_WIDTH * 3];
+    for (u32 y = 0; y < height; y++) {
+        for (u32 x = 0; x < width; x++) {
+            u32 pixel = pixels[y * width + x];
+            rgb[x * 3    ] = (u8)(pixel >> 16);
+            rgb[x * 3 + 1] = (u8)(pixel >> 8);
+            rgb[x * 3 + 2] = (u8)pixel;
+        }
+        fwrite(rgb, 3, width, file);
+    }
+    return fclose(file) == 0;
+}
+
+bool readImage(const char *path, u32 *pixels, u32 width, u32 height) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+    u32 file_width = 0, file_height = 0, max_value = 0;
+    bool valid = fscanf(file, "P6 %u %u %u", &file_width, &file_height, &max_value) == 3 &&
+                 fgetc(file) != EOF &&
+                 file_width == width && file_height == height && max_value == 255;
+    u8 rgb[GOLDEN_WIDTH * 3];
+    for (u32 y = 0; valid && y < height; y++) {
+        valid = fread(rgb, 3, width, file) == width;
+        for (u32 x = 0; valid && x < width; x++)
+            pixels[y * width + x] = (u32)rgb[x * 3] << 16 | (u32)rgb[x * 3 + 1] << 8 | (u32)rgb[x * 3 + 2];
+    }
+    fclose(file);
+    return valid;
+}
+
+INLINE u32 getChannelDifference(u32 a, u32 b, u32 shift) {
+    i32 difference = (i32)((a >> shift) & 255) - (i32)((b >> shift) & 255);
+    return (u32)(difference < 0 ? -difference : difference);
+}
+
+// Per-pixel comparison (the largest channel difference of a pixel must be within the tolerance),
+// marking mismatches in red over a dimmed copy of the reference:
+u32 compareImages(const u32 *pixels, const u32 *reference, u32 *diff, u32 pixel_count, u32 tolerance, u32 *max_difference) {
+    u32 mismatched_count = 0;
+    *max_difference = 0;
+    for (u32 i = 0; i < pixel_count; i++) {
+        u32 difference = getChannelDifference(pixels[i], reference[i], 0);
+        u32 green = getChannelDifference(pixels[i], reference[i], 8);
+        u32 red = getChannelDifference(pixels[i], reference[i], 16);
+        if (green > difference) difference = green;
+        if (red > difference) difference = red;
+        if (difference > *max_difference) *max_difference = difference;
+        if (difference > tolerance) {
+            mismatched_count++;
+            diff[i] = 0xFF0000;
+        } else
+            diff[i] = (reference[i] >> 2) & 0x3F3F3F;
+    }
+    return mismatched_count;
+}
+
+u32 reference_pixels[GOLDEN_WIDTH * GOLDEN_HEIGHT];
+u32 diff_pixels[GOLDEN_WIDTH * GOLDEN_HEIGHT];
+
+void printUsage(const char *program_name) {
+    printf("Usage: %s [--references DIR] [--output DIR] [--tolerance N] [--repetitions N] [--planes] [--update]\n", program_name);
+}
+
+int main(int argc, char **argv) {
+    const char *reference_directory = GOLDEN_DEFAULT__REFERENCE_DIRECTORY;
+    const char *output_directory = ".";
+    u32 tolerance = GOLDEN_DEFAULT__TOLERANCE;
+    u32 repetitions = GOLDEN_DEFAULT__REPETITIONS;
+    bool planes = false;
+    bool update = false;
+    for (int i = 1; i < argc; i++) {
+        if (     !strcmp(argv[i], "--references" ) && i + 1 < argc) reference_directory = argv[++i];
+        else if (!strcmp(argv[i], "--output"     ) && i + 1 < argc) output_directory = argv[++i];
+        else if (!strcmp(argv[i], "--tolerance"  ) && i + 1 < argc) tolerance = (u32)strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--repetitions") && i + 1 < argc) repetitions = (u32)strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--planes")) planes = true;
+        else if (!strcmp(argv[i], "--update")) update = true;
+        else {
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+    if (!repetitions) repetitions = 1;
+
+    initTime();
+    workers::setThreadCount(1);
+    controls::key_map::space = POSIX_VK_SPACE;
+    controls::key_map::up = POSIX_VK_UP;
+
+    void *memory = os::getMemory(WINDOW_CONTENT_SIZE + CANVAS_SIZE);
+    if (!memory) {
+        printf("Failed to allocate memory\n");
+        return -1;
+    }
+    window::content = (u32*)memory;
+    window::canvas.pixels = (PixelQuad*)((u8*)memory + WINDOW_CONTENT_SIZE);
+    if (planes) window::canvas.setStorage(CanvasStorage::Planes);
+
+    // Size everything without running a (timing dependent) frame:
+    window::width = GOLDEN_WIDTH;
+    window::height = GOLDEN_HEIGHT;
+    window::canvas.dimensions.update(GOLDEN_WIDTH, GOLDEN_HEIGHT);
+    game = new WireBreakout();
+    game->OnWindowResize(GOLDEN_WIDTH, GOLDEN_HEIGHT);
+
+    generateTorus();
+    mesh_viewport.updateDimensions(GOLDEN_WIDTH, GOLDEN_HEIGHT);
+
+    const u32 pixel_count = GOLDEN_WIDTH * GOLDEN_HEIGHT;
+    const char *storage_suffix = planes ? "_planes" : "";
+    char path[1024];
+    u32 failed_count = 0;
+    for (const GoldenScene &scene : scenes) {
+        scene.setup();
+
+        // Render once for the image, then time repeated renders of the same (unchanging) scene:
+        renderFrame(scene);
+        u64 start_ticks = time::getTicks();
+        for (u32 i = 0; i < repetitions; i++) renderFrame(scene);
+        f64 milliseconds = (f64)(time::getTicks() - start_ticks) * time::milliseconds_per_tick / (f64)repetitions;
+
+        snprintf(path, sizeof(path), "%s/%s%s.ppm", output_directory, scene.name, storage_suffix);
+        writeImage(path, window::content, GOLDEN_WIDTH, GOLDEN_HEIGHT);
+
+        snprintf(path, sizeof(path), "%s/%s%s.ppm", reference_directory, scene.name, storage_suffix);
+        const char *result;
+        u32 max_difference = 0;
+        u32 mismatched_count = 0;
+        if (update)
+            result = writeImage(path, window::content, GOLDEN_WIDTH, GOLDEN_HEIGHT) ? "updated" : "write_failed";
+        else if (!readImage(path, reference_pixels, GOLDEN_WIDTH, GOLDEN_HEIGHT))
+            result = "missing_reference";
+        else {
+            mismatched_count = compareImages(window::content, reference_pixels, diff_pixels, pixel_count, tolerance, &max_difference);
+            result = mismatched_count ? "fail" : "pass";
+            if (mismatched_count) {
+                snprintf(path, sizeof(path), "%s/%s%s_diff.ppm", output_directory, scene.name, storage_suffix);
+                writeImage(path, diff_pixels, GOLDEN_WIDTH, GOLDEN_HEIGHT);
+            }
+        }
+        if (strcmp(result, "pass") && strcmp(result, "updated")) failed_count++;
+
+        printf("golden scene=%s storage=%s resolution=%ux%u render_ms=%.3f tolerance=%u max_difference=%u mismatched_pixels=%u result=%s\n",
+               scene.name, planes ? "planes" : "quads", GOLDEN_WIDTH, GOLDEN_HEIGHT, milliseconds,
+               tolerance, max_difference, mismatched_count, result);
+    }
+
+    return failed_count ? 1 : 0;
+}
@@ -0,0 +1,100 @@
+// Line rasterization microbenchmark:
+// Times drawing a fixed set of wire-frame like lines (some of them crossing the viewport's edges)
+// with each rasterizer variant: Storage layout, antialiased or aliased, with or without depth, opaque or blended.
+// Prints one machine-readable line per case.
+
+#define SLIM_ENGINE_NO_MAIN
+#include "../SlimEngine/app.h"
+#include "../SlimEngine/draw/line.h"
+
+#define LINES_BENCHMARK_MIN_SECONDS 0.25
+#define LINES_BENCHMARK_LINE_COUNT 4096
+#define LINES_BENCHMARK_WIDTH 1920
+#define LINES_BENCHMARK_HEIGHT 1080
+
+struct BenchmarkLine {
+    f32 x1, y1, x2, y2;
+    f64 z1, z2;
+    vec3 color;
+};
+
+BenchmarkLine benchmark_lines[LINES_BENCHMARK_LINE_COUNT];
+
+u32 random_state = 0x12345678u;
+INLINE f32 randomUnit() {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return (f32)(random_state >> 8) * (1.0f / (f32)(1 << 24));
+}
+
+// Short to medium segments of every orientation, about a tenth of them reaching outside the viewport:
+void generateLines() {
+    for (BenchmarkLine &line : benchmark_lines) {
+        f32 length = 8 + randomUnit() * 120;
+        f32 angle = randomUnit() * TAU;
+        line.x1 = -40 + randomUnit() * (LINES_BENCHMARK_WIDTH  + 80);
+        line.y1 = -40 + randomUnit() * (LINES_BENCHMARK_HEIGHT + 80);
+        line.x2 = line.x1 + cosf(angle) * length;
+        line.y2 = line.y1 + sinf(angle) * length;
+        line.z1 = 2 + randomUnit() * 20;
+        line.z2 = 2 + randomUnit() * 20;
+        line.color = vec3{randomUnit(), randomUnit(), randomUnit()};
+    }
+}
+
+f64 measure(Viewport &viewport, bool depth, f32 opacity, u32 *iterations) {
+    viewport.canvas.clear();
+    u32 count = 0;
+    u64 start_ticks = time::getTicks();
+    u64 end_ticks = start_ticks;
+    while ((f64)(end_ticks - start_ticks) * time::seconds_per_tick < LINES_BENCHMARK_MIN_SECONDS) {
+        for (BenchmarkLine &line : benchmark_lines)
+            drawLine(line.x1, line.y1, depth ? line.z1 : 0,
+                     line.x2, line.y2, depth ? line.z2 : 0,
+                     viewport, line.color, opacity, 1);
+        count++;
+        end_ticks = time::getTicks();
+    }
+    *iterations = count;
+    return (f64)(end_ticks - start_ticks) * time::nanoseconds_per_tick / (f64)count;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 1) {
+        printf("Usage: %s\n", argv[0]);
+        return -1;
+    }
+    initTime();
+    workers::setThreadCount(1);
+    generateLines();
+
+    Canvas canvas{(PixelQuad*)os::getMemory(CANVAS_SIZE)};
+    if (!canvas.pixels) {
+        printf("Failed to allocate memory\n");
+        return -1;
+    }
+    canvas.dimensions.update(LINES_BENCHMARK_WIDTH, LINES_BENCHMARK_HEIGHT);
+
+    Camera camera;
+    Viewport viewport{canvas, &camera};
+
+    const char *storage_names[] = {"quads", "planes"};
+    CanvasStorage storages[] = {CanvasStorage::PixelQuads, CanvasStorage::Planes};
+    u32 iterations;
+    for (u8 s = 0; s < 2; s++)
+        for (u8 aa = 0; aa < 2; aa++)
+            for (u8 depth = 0; depth < 2; depth++)
+                for (u8 opaque = 0; opaque < 2; opaque++) {
+                    canvas.setStorage(storages[s]);
+                    canvas.antialias = aa != 0;
+                    viewport.updateDimensions(LINES_BENCHMARK_WIDTH, LINES_BENCHMARK_HEIGHT);
+                    f64 nanoseconds = measure(viewport, depth, opaque ? 1.0f : 0.5f, &iterations);
+                    printf("lines storage=%s antialias=%d depth=%d opaque=%d resolution=%ux%u lines=%u iterations=%u ns_per_op=%.0f lines_per_second=%.0f\n",
+                           storage_names[s], (int)aa, (int)depth, (int)opaque,
+                           LINES_BENCHMARK_WIDTH, LINES_BENCHMARK_HEIGHT, LINES_BENCHMARK_LINE_COUNT, iterations,
+                           nanoseconds, (f64)LINES_BENCHMARK_LINE_COUNT * 1000000000.0 / nanoseconds);
+                }
+
+    return 0;
+}
@@ -0,0 +1,134 @@
+// Resolve microbenchmark:
+// Times resolving a sparsely drawn canvas into window content for each storage layout and resolve kernel,
+// verifying that all planar kernels (and the multi-threaded resolve) produce bit-identical content to the scalar one.
+// Prints one machine-readable line per case.
+
+#define SLIM_ENGINE_NO_MAIN
+#include "../SlimEngine/app.h"
+
+#define RESOLVE_BENCHMARK_MIN_SECONDS 0.25
+
+struct ResolveResolution {
+    u16 width, height;
+};
+
+ResolveResolution resolutions[] = {
+    {640, 480},
+    {1920, 1080},
+    {3840, 2160}
+};
+
+INLINE u32 hashSample(u32 x, u32 y) {
+    u32 h = x * 0x9E3779B1u ^ y * 0x85EBCA77u;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    return h;
+}
+
+// Wire-frame like content: a few horizontal and diagonal strokes plus scattered samples, the rest is background:
+void drawPattern(Canvas &canvas) {
+    canvas.clear();
+    i32 sample_width  = canvas.dimensions.width  * (canvas.antialias ? 2 : 1);
+    i32 sample_height = canvas.dimensions.height * (canvas.antialias ? 2 : 1);
+    for (i32 y = 0; y < sample_height; y++)
+        for (i32 x = 0; x < sample_width; x++) {
+            u32 h = hashSample((u32)x, (u32)y);
+            bool on_stroke = (y % 37) < 2 || ((x + y) % 53) < 2;
+            if (on_stroke || (h & 63) == 0) {
+                vec3 color{
+                    (f32)((h >> 8 ) & 255) * COLOR_COMPONENT_TO_FLOAT,
+                    (f32)((h >> 16) & 255) * COLOR_COMPONENT_TO_FLOAT,
+                    (f32)((h >> 24) & 255) * COLOR_COMPONENT_TO_FLOAT
+                };
+                canvas.setPixel(x, y, color, (f32)((h & 3) + 1) * 0.25f, (f64)(h & 1023) * 0.01);
+            }
+        }
+}
+
+f64 measure(Canvas &canvas, u32 *content, resolve::Kernel kernel, u32 *iterations, bool threaded = false) {
+    u32 pixel_count = canvas.dimensions.width_times_height;
+    u32 count = 0;
+    u64 start_ticks = time::getTicks();
+    u64 end_ticks = start_ticks;
+    while ((f64)(end_ticks - start_ticks) * time::seconds_per_tick < RESOLVE_BENCHMARK_MIN_SECONDS) {
+        if (threaded) {
+            resolve::kernel = kernel;
+            resolve::runAll(canvas, content);
+        } else if (canvas.storage == CanvasStorage::Planes)
+            resolve::planes(canvas, content, 0, pixel_count, kernel);
+        else
+            resolve::quads(canvas, content, 0, pixel_count);
+        count++;
+        end_ticks = time::getTicks();
+    }
+    *iterations = count;
+    return (f64)(end_ticks - start_ticks) * time::nanoseconds_per_tick / (f64)count;
+}
+
+void report(const char *storage, const char *kernel, u32 threads, bool antialias, ResolveResolution &resolution,
+            f64 nanoseconds, u32 iterations, bool identical) {
+    f64 pixel_count = (f64)resolution.width * (f64)resolution.height;
+    printf("resolve storage=%s kernel=%s threads=%u antialias=%d resolution=%ux%u iterations=%u ns_per_op=%.0f pixels_per_second=%.0f identical=%d\n",
+           storage, kernel, threads, (int)antialias, (unsigned int)resolution.width, (unsigned int)resolution.height,
+           iterations, nanoseconds, pixel_count * 1000000000.0 / nanoseconds, (int)identical);
+}
+
+int main(int argc, char **argv) {
+    initTime();
+
+    u32 thread_count = os::getProcessorCount();
+    if (argc == 3 && !strcmp(argv[1], "--threads")) thread_count = (u32)strtoul(argv[2], nullptr, 10);
+    else if (argc != 1) {
+        printf("Usage: %s [--threads N]\n", argv[0]);
+        return -1;
+    }
+    workers::setThreadCount(thread_count);
+    thread_count = workers::thread_count;
+
+    u32 *content = (u32*)os::getMemory(WINDOW_CONTENT_SIZE * 2);
+    u32 *reference_content = content + MAX_WINDOW_SIZE;
+    Canvas quads_canvas{(PixelQuad*)os::getMemory(CANVAS_SIZE)};
+    Canvas planes_canvas{(PixelQuad*)os::getMemory(CANVAS_SIZE)};
+    if (!content || !quads_canvas.pixels || !planes_canvas.pixels) {
+        printf("Failed to allocate memory\n");
+        return -1;
+    }
+    planes_canvas.setStorage(CanvasStorage::Planes);
+    printf("resolve supported_kernel=%s\n", resolve::getKernelName(resolve::supported_kernel));
+
+    resolve::Kernel kernels[] = {resolve::Kernel::Scalar, resolve::Kernel::SSE, resolve::Kernel::AVX2};
+    bool all_identical = true;
+    u32 iterations;
+    f64 nanoseconds;
+    for (u8 aa = 0; aa < 2; aa++)
+        for (ResolveResolution &resolution : resolutions) {
+            quads_canvas.antialias = planes_canvas.antialias = aa != 0;
+            quads_canvas.dimensions.update(resolution.width, resolution.height);
+            planes_canvas.dimensions.update(resolution.width, resolution.height);
+            drawPattern(quads_canvas);
+            drawPattern(planes_canvas);
+            u32 content_size = quads_canvas.dimensions.width_times_height * PIXEL_SIZE;
+
+            nanoseconds = measure(quads_canvas, content, resolve::Kernel::Scalar, &iterations);
+            report("quads", "scalar", 1, aa, resolution, nanoseconds, iterations, true);
+
+            resolve::planesScalar(planes_canvas, reference_content, 0, planes_canvas.dimensions.width_times_height);
+            for (resolve::Kernel kernel : kernels) {
+                if (kernel > resolve::supported_kernel) continue;
+                memset(content, 0, content_size);
+                nanoseconds = measure(planes_canvas, content, kernel, &iterations);
+                bool identical = !memcmp(content, reference_content, content_size);
+                all_identical = all_identical && identical;
+                report("planes", resolve::getKernelName(kernel), 1, aa, resolution, nanoseconds, iterations, identical);
+            }
+
+            memset(content, 0, content_size);
+            nanoseconds = measure(planes_canvas, content, resolve::supported_kernel, &iterations, true);
+            bool identical = !memcmp(content, reference_content, content_size);
+            all_identical = all_identical && identical;
+            report("planes", resolve::getKernelName(resolve::supported_kernel), thread_count, aa, resolution, nanoseconds, iterations, identical);
+        }
+
+    return all_identical ? 0 : 1;
+}
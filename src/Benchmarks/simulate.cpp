@@ -0,0 +1,83 @@
+// Batch game simulator:
+// Plays many independent games through the shipped levels (headless, with no rendering), spread over worker threads.
+// Each game is stepped with a fixed delta time by an autopilot that follows the ball with the paddle and launches it,
+// and gets its own (seeded) offset of the ball's start velocity. Prints one machine-readable line per level with its
+// outcome statistics, then a summary line with the simulated game-seconds per wall-clock second.
+
+#define SLIM_ENGINE_NO_MAIN
+#include "../SlimEngine/app.h"
+#include "../GameLib/simulation.hpp"
+#include "../GameLib/maps.hpp"
+
+#define SIMULATE_DEFAULT__GAMES_COUNT 1024
+
+char *maps[GameMaps::levels_count]{GameMaps::level01, GameMaps::level02};
+
+void printUsage(const char *program) {
+    printf("Usage: %s [--games N] [--threads N] [--delta-time SECONDS] [--max-seconds SECONDS] "
+           "[--lives N] [--spread SPEED] [--launch-speed SPEED] [--seed N] [--no-follow]\n", program);
+}
+
+int main(int argc, char **argv) {
+    Simulation simulation;
+    SimulationSettings &settings = simulation.settings;
+    settings.maps = maps;
+    settings.maps_count = GameMaps::levels_count;
+    settings.ball_start_velocity_spread = 10;
+
+    u32 games_count = SIMULATE_DEFAULT__GAMES_COUNT;
+    u32 thread_count = os::getProcessorCount();
+    for (int i = 1; i < argc; i++) {
+        if (     !strcmp(argv[i], "--games"       ) && i + 1 < argc) games_count = (u32)strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--threads"     ) && i + 1 < argc) thread_count = (u32)strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--delta-time"  ) && i + 1 < argc) settings.delta_time = strtof(argv[++i], nullptr);
+        else if (!strcmp(argv[i], "--max-seconds" ) && i + 1 < argc) settings.max_level_seconds = strtof(argv[++i], nullptr);
+        else if (!strcmp(argv[i], "--lives"       ) && i + 1 < argc) settings.starting_lives = (u8)strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--spread"      ) && i + 1 < argc) settings.ball_start_velocity_spread = strtof(argv[++i], nullptr);
+        else if (!strcmp(argv[i], "--launch-speed") && i + 1 < argc) settings.launch_speed = strtof(argv[++i], nullptr);
+        else if (!strcmp(argv[i], "--seed"        ) && i + 1 < argc) settings.seed = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--no-follow")) settings.script.follow_ball = false;
+        else {
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+    if (!games_count || !settings.starting_lives || settings.delta_time <= 0) {
+        printUsage(argv[0]);
+        return -1;
+    }
+
+    initTime();
+    workers::setThreadCount(thread_count);
+    thread_count = workers::thread_count;
+
+    if (!simulation.allocate(games_count)) {
+        printf("Failed to allocate memory\n");
+        return -1;
+    }
+
+    u64 start_ticks = time::getTicks();
+    simulation.run();
+    f64 wall_seconds = (f64)(time::getTicks() - start_ticks) * time::seconds_per_tick;
+
+    for (u8 l = 0; l < settings.maps_count; l++) {
+        SimulationLevelStatistics &statistics = simulation.level_statistics[l];
+        f64 completed_count = statistics.completed_count ? (f64)statistics.completed_count : 1;
+        f64 failed_count = statistics.failed_count ? (f64)statistics.failed_count : 1;
+        printf("simulation level=%u reached=%u completed=%u failed=%u timed_out=%u "
+               "mean_completed_seconds=%.2f min_completed_seconds=%.2f max_completed_seconds=%.2f "
+               "mean_completed_lives_lost=%.2f mean_failed_bricks_remaining=%.2f\n",
+               (unsigned int)l + 1, statistics.reached_count, statistics.completed_count, statistics.failed_count,
+               statistics.timed_out_count,
+               statistics.completed_seconds_sum / completed_count,
+               statistics.min_completed_seconds, statistics.max_completed_seconds,
+               (f64)statistics.completed_lives_lost_sum / completed_count,
+               (f64)statistics.failed_bricks_remaining_sum / failed_count);
+    }
+    printf("simulation games=%u threads=%u delta_time=%f steps=%llu game_seconds=%.1f wall_seconds=%.3f "
+           "game_seconds_per_wall_second=%.0f\n",
+           games_count, thread_count, settings.delta_time, (unsigned long long)simulation.steps_count,
+           simulation.game_seconds, wall_seconds, simulation.game_seconds / wall_seconds);
+
+    return 0;
+}
@@ -7,12 +7,14 @@ struct Ball {
     static constexpr ColorID DEFAULT_COLOR = White;
 
     vec2 position;
+    vec2 previous_position; // As of the start of the last update (for interpolated rendering)
     vec2 velocity;
     float radius;
     ColorID color_id;
 
     Ball(float radius = DEFAULT_RADIUS, ColorID color_id = DEFAULT_COLOR) :
         position{0},
+        previous_position{0},
         velocity{0},
         radius{radius},
         color_id(color_id)
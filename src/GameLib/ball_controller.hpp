@@ -3,6 +3,7 @@
 #include "./ball.hpp"
 #include "./paddle.hpp"
 #include "./level.hpp"
+#include "../SlimEngine/core/profiler.h"
 
 struct BallController {
     static constexpr float DEFAULT_START_POSITION_X = 0;
@@ -10,6 +11,10 @@ struct BallController {
     static constexpr float DEFAULT_START_VELOCITY_X = 30;
     static constexpr float DEFAULT_START_VELOCITY_y = -35;
 
+    // A ball wedged in between the paddle and a side bound keeps hitting both at no distance, never running out
+    // of movement, so the hits resolved per update are capped (leaving the ball where its last hit left it):
+    static constexpr u8 MAX_HITS_PER_UPDATE = 16;
+
     Ball &ball;
 
     vec2 start_position;
@@ -24,7 +29,7 @@ struct BallController {
     {}
 
     void reset() {
-        ball.position = start_position;
+        ball.position = ball.previous_position = start_position;
         ball.velocity = start_velocity;
     }
 
@@ -36,9 +41,11 @@ struct BallController {
         ball.velocity.y = speed;
     }
 
-    void update(float delta_time, const vec2 &game_scale, const Paddle &paddle, Brick *bricks, u8 bricks_count) {
+    void update(float delta_time, const vec2 &game_scale, const Paddle &paddle, Level &level) {
+        PROFILE_ZONE("BallController::update");
         Rect rect;
 
+        ball.previous_position = ball.position;
         if (ball.position.y <= (paddle.rect.top + ball.radius)) {
             // The ball is within range for the paddle:
             // This section is only used for the cases where the ball starts-out already within the paddle bounds.
@@ -102,8 +109,9 @@ struct BallController {
         // Iteratively resolve the ball's movement:
         // At each step the closest hit is found and handled while tracking the overall amount the ball has moved
         i32 hit_brick_index;
+        BrickArrays &bricks = level.bricks;
         t_remaining = 1.0f;
-        while (t_remaining) {
+        for (u8 hits = 0; t_remaining && hits < MAX_HITS_PER_UPDATE; hits++) {
             // Each iteration the t_min is reset such that multiple successive intersection-checks can be made
             // so that the closes-hit if found:
             t_min = 1.0f;
@@ -114,14 +122,14 @@ struct BallController {
                 f32 t = (x_bound - old_position.x) / movement.x;
                 if (t < t_min) {
                     t_min = t;
-                    hit_normal = {-1.0f, 0};
+                    hit_normal = {-1.0f, 0.0f};
                 }
             }
             if (new_position.x <= -x_bound) {
                 f32 t = (-x_bound - old_position.x) / movement.x;
                 if (t < t_min) {
                     t_min = t;
-                    hit_normal = {1.0f, 0};
+                    hit_normal = {1.0f, 0.0f};
                 }
             }
             if (new_position.y >=  y_bound) {
@@ -133,10 +141,14 @@ struct BallController {
             }
 
             if (new_position.y > game_scale.y) { // Ball is around the bricks:
-                for (i32 i = 0; i < bricks_count; i++)
-                    if (!bricks[i].is_broken() &&
-                        hitBrickRect(bricks[i].rect)) // Test using the Minkowski Sum for Rectangle/Circle
+                // Only test the bricks in the grid cells that the ball's path sweeps through:
+                u32 candidates_count = level.grid.query(old_position, new_position, ball.radius);
+                for (u32 c = 0; c < candidates_count; c++) {
+                    i32 i = (i32)level.grid.candidates[c];
+                    if (bricks.isAlive((u32)i) &&
+                        hitBrickRect(bricks.getRect((u32)i))) // Test using the Minkowski Sum for Rectangle/Circle
                         hit_brick_index = i; // Track the hit brick index
+                }
             } else // Ball is around the paddle:
                 hitBrickRect( paddle.rect);  // Test using the Minkowski Sum for Rectangle/Circle
 
@@ -149,11 +161,15 @@ struct BallController {
                 movement = ball.velocity * (delta_time * t_remaining);
                 movement_distance = movement.length();
                 new_position = old_position + movement;
-                if (hit_brick_index >= 0) bricks[hit_brick_index].hit(); // If a brick was hit in this iteration, hit it
+                if (hit_brick_index >= 0) { // If a brick was hit in this iteration, hit it
+                    bricks.hit((u32)hit_brick_index);
+                    if (!bricks.isAlive((u32)hit_brick_index)) level.grid.remove((u32)hit_brick_index);
+                }
             }
         }
 
-        ball.position = new_position;
+        // Movement left over from capping the hits was never checked for collisions, so it is dropped:
+        ball.position = t_remaining ? old_position : new_position;
     }
 
     // Intersection test in local-space of the ball against a perpendicular bound ahead of it
@@ -232,6 +248,8 @@ struct BallController {
     bool hitCorner(const vec2 &C, f32 min_t) {
         vec2 Rd = new_position - hit_position;
         f32 remaining_distance = Rd.length();
+        if (remaining_distance == 0) // The hit is right at the end of the movement - nothing left to hit
+            return false;
         Rd /= remaining_distance;
 
         f32 t = Rd.dot(C - hit_position);
@@ -12,6 +12,7 @@ struct BrickBase {
 
     float scale_x;
     float speed_x;
+    float previous_position_x; // As of the start of the last update (for interpolated rendering)
 
     BrickBase(vec2 position = {},
           ColorID color_id = DEFAULT_COLOR,
@@ -21,7 +22,8 @@ struct BrickBase {
           position{position},
           color_id{color_id},
           scale_x{scale_x},
-          speed_x{speed_x}
+          speed_x{speed_x},
+          previous_position_x{position.x}
     {
         updateRect();
     }
@@ -36,6 +38,7 @@ struct BrickBase {
     // Slide rick horizontally, flipping direction when the level's sides are hit
     // Note: This is used for both the paddle movement and sliding bricks
     void update(float delta_time, float level_bound_x, bool flip_direction = false) {
+        previous_position_x = position.x;
         level_bound_x -= scale_x;
         float movement = speed_x * delta_time;
         if (movement > 0) { // Sliding right:
@@ -0,0 +1,243 @@
+#pragma once
+
+#include "./brick.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SLIM_X86 1
+#include <immintrin.h>
+#endif
+
+#ifdef COMPILER_MSVC
+#include <intrin.h>
+INLINE u32 countBits(u64 bits) { return (u32)__popcnt64(bits); }
+INLINE u32 lowestBitIndex(u64 bits) { unsigned long index; _BitScanForward64(&index, bits); return (u32)index; }
+#else
+INLINE u32 countBits(u64 bits) { return (u32)__builtin_popcountll(bits); }
+INLINE u32 lowestBitIndex(u64 bits) { return (u32)__builtin_ctzll(bits); }
+#endif
+
+struct BrickView;
+
+// Structure-of-arrays storage of a level's bricks:
+// Every field lives in its own array, so each pass only streams through the fields it uses,
+// 4 bricks at a time where it's vectorized. Broken bricks are culled via a bit mask (a bit per brick),
+// which also makes counting the remaining ones a matter of counting bits.
+// A single brick can still be handled with the Brick API through a BrickView (bricks[i]).
+struct BrickArrays {
+    u64 *alive{nullptr};     // Set while the brick is not broken
+    u64 *breakable{nullptr}; // Set if the brick can be broken
+    f32 *lefts{nullptr}, *rights{nullptr}, *tops{nullptr}, *bottoms{nullptr};
+    f32 *positions_x{nullptr}, *positions_y{nullptr};
+    f32 *previous_positions_x{nullptr}; // As of the start of the last update (for interpolated rendering)
+    f32 *scales_x{nullptr};
+    f32 *speeds_x{nullptr};
+    ColorID *color_ids{nullptr};
+    ColorID *hit_color_ids{nullptr};
+    char *hits_to_break{nullptr};
+    u32 count{0}, capacity{0};
+
+    INLINE static u32 getWordCount(u32 bricks_count) { return (bricks_count + 63) / 64; }
+
+    // Arrays are padded to a multiple of 4 bricks (keeping each one 16-byte aligned):
+    static u64 getSizeInBytes(u32 bricks_count) {
+        u64 padded_count = (bricks_count + 3) & ~3u;
+        return sizeof(u64) * 2 * getWordCount(bricks_count) +
+               padded_count * (sizeof(f32) * 9 + sizeof(ColorID) * 2 + sizeof(char));
+    }
+
+    bool allocate(u32 bricks_count, memory::MonotonicAllocator &memory_allocator) {
+        count = capacity = 0;
+        u64 words_size = sizeof(u64) * getWordCount(bricks_count);
+        u64 padded_count = (bricks_count + 3) & ~3u;
+        alive                = (u64*)memory_allocator.allocate(words_size);
+        breakable            = (u64*)memory_allocator.allocate(words_size);
+        lefts                = (f32*)memory_allocator.allocate(sizeof(f32) * padded_count);
+        rights               = (f32*)memory_allocator.allocate(sizeof(f32) * padded_count);
+        tops                 = (f32*)memory_allocator.allocate(sizeof(f32) * padded_count);
+        bottoms              = (f32*)memory_allocator.allocate(sizeof(f32) * padded_count);
+        positions_x          = (f32*)memory_allocator.allocate(sizeof(f32) * padded_count);
+        positions_y          = (f32*)memory_allocator.allocate(sizeof(f32) * padded_count);
+        previous_positions_x = (f32*)memory_allocator.allocate(sizeof(f32) * padded_count);
+        scales_x             = (f32*)memory_allocator.allocate(sizeof(f32) * padded_count);
+        speeds_x             = (f32*)memory_allocator.allocate(sizeof(f32) * padded_count);
+        color_ids            = (ColorID*)memory_allocator.allocate(sizeof(ColorID) * padded_count);
+        hit_color_ids        = (ColorID*)memory_allocator.allocate(sizeof(ColorID) * padded_count);
+        hits_to_break        = (char*)memory_allocator.allocate(sizeof(char) * padded_count);
+        if (bricks_count && !hits_to_break) return false;
+
+        capacity = bricks_count;
+        for (u32 i = 0; i < getWordCount(bricks_count); i++) alive[i] = breakable[i] = 0;
+        return true;
+    }
+
+    INLINE bool isAlive(u32 i) const { return (alive[i >> 6] >> (i & 63)) & 1; }
+    INLINE bool isBreakable(u32 i) const { return (breakable[i >> 6] >> (i & 63)) & 1; }
+    INLINE bool isMovable(u32 i) const { return speeds_x[i] != 0; }
+    INLINE Rect getRect(u32 i) const { return {lefts[i], rights[i], tops[i], bottoms[i]}; }
+    INLINE vec2 getPosition(u32 i) const { return {positions_x[i], positions_y[i]}; }
+
+    INLINE void updateRect(u32 i) {
+        lefts[i] = positions_x[i] - scales_x[i];
+        rights[i] = positions_x[i] + scales_x[i];
+        tops[i] = positions_y[i] + 1;
+        bottoms[i] = positions_y[i] - 1;
+    }
+
+    void set(u32 i, const Brick &brick) {
+        positions_x[i] = brick.position.x;
+        positions_y[i] = brick.position.y;
+        previous_positions_x[i] = brick.previous_position_x;
+        scales_x[i] = brick.scale_x;
+        speeds_x[i] = brick.speed_x;
+        color_ids[i] = brick.color_id;
+        hit_color_ids[i] = brick.hit_color_id;
+        hits_to_break[i] = brick.hits_to_break;
+        updateRect(i);
+
+        u64 bit = 1ULL << (i & 63);
+        if (brick.hits_to_break) alive[i >> 6] |= bit; else alive[i >> 6] &= ~bit;
+        if (brick.hits_to_break != -1) breakable[i >> 6] |= bit; else breakable[i >> 6] &= ~bit;
+    }
+
+    Brick get(u32 i) const {
+        Brick brick{getPosition(i), hits_to_break[i], speeds_x[i], color_ids[i], hit_color_ids[i], scales_x[i]};
+        brick.previous_position_x = previous_positions_x[i];
+        return brick;
+    }
+
+    INLINE void add(const Brick &brick) { if (count < capacity) set(count++, brick); }
+
+    void hit(u32 i) {
+        if (hits_to_break[i] > 0) {
+            hits_to_break[i]--;
+            color_ids[i] = hit_color_ids[i];
+            if (!hits_to_break[i]) alive[i >> 6] &= ~(1ULL << (i & 63));
+        }
+    }
+
+    // Breakable bricks that are not yet broken:
+    u32 countRemaining() const {
+        u32 remaining = 0;
+        for (u32 i = 0, words = getWordCount(count); i < words; i++) remaining += countBits(alive[i] & breakable[i]);
+        return remaining;
+    }
+
+    INLINE BrickView operator[](u32 i);
+
+    // Slide all (movable) bricks horizontally, flipping their direction when the level's sides are hit
+    // (as BrickBase::update does, lane for lane, so results are identical).
+    // Brick rects are left as they were, for updateRects to refresh once any collisions between bricks are resolved:
+    void slide(f32 delta_time, f32 level_bound_x) {
+        u32 i = 0;
+#ifdef SLIM_X86
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 sign = _mm_set1_ps(-0.0f);
+        const __m128 time = _mm_set1_ps(delta_time);
+        const __m128 level_bound = _mm_set1_ps(level_bound_x);
+        for (; i + 4 <= count; i += 4) {
+            __m128 position = _mm_loadu_ps(positions_x + i);
+            __m128 speed = _mm_loadu_ps(speeds_x + i);
+            __m128 bound = _mm_sub_ps(level_bound, _mm_loadu_ps(scales_x + i));
+            __m128 movement = _mm_mul_ps(speed, time);
+            __m128 right_distance = _mm_sub_ps(bound, position);
+            __m128 left_distance = _mm_add_ps(position, bound);
+
+            // Lanes sliding into a side they reach during this step get flipped, the rest just move:
+            __m128 flip_right = _mm_andnot_ps(
+                    _mm_or_ps(_mm_cmplt_ps(right_distance, zero), _mm_cmpgt_ps(right_distance, movement)),
+                    _mm_cmpgt_ps(movement, zero));
+            __m128 flip_left = _mm_andnot_ps(
+                    _mm_or_ps(_mm_cmplt_ps(left_distance, zero), _mm_cmpgt_ps(left_distance, _mm_xor_ps(movement, sign))),
+                    _mm_cmplt_ps(movement, zero));
+            __m128 flip = _mm_or_ps(flip_right, flip_left);
+            __m128 moving = _mm_cmpneq_ps(movement, zero);
+
+            __m128 new_position = _mm_or_ps(_mm_and_ps(moving, _mm_add_ps(position, movement)), _mm_andnot_ps(moving, position));
+            new_position = _mm_or_ps(_mm_andnot_ps(flip, new_position),
+                                     _mm_or_ps(_mm_and_ps(flip_right, _mm_add_ps(bound, right_distance)),
+                                               _mm_and_ps(flip_left, _mm_sub_ps(left_distance, bound))));
+            _mm_storeu_ps(previous_positions_x + i, position);
+            _mm_storeu_ps(positions_x + i, new_position);
+            _mm_storeu_ps(speeds_x + i, _mm_xor_ps(speed, _mm_and_ps(flip, sign)));
+        }
+#endif
+        for (; i < count; i++) {
+            f32 &position = positions_x[i];
+            f32 &speed = speeds_x[i];
+            f32 bound = level_bound_x - scales_x[i];
+            f32 movement = speed * delta_time;
+            previous_positions_x[i] = position;
+            if (movement > 0) {
+                f32 distance = bound - position;
+                if (distance < 0 || distance > movement) position += movement;
+                else {
+                    speed = -speed;
+                    position = bound + distance;
+                }
+            } else if (movement < 0) {
+                f32 distance = position + bound;
+                if (distance < 0 || distance > -movement) position += movement;
+                else {
+                    speed = -speed;
+                    position = -bound + distance;
+                }
+            }
+        }
+    }
+
+    void updateRects() {
+        u32 i = 0;
+#ifdef SLIM_X86
+        for (; i + 4 <= count; i += 4) {
+            __m128 position = _mm_loadu_ps(positions_x + i);
+            __m128 scale = _mm_loadu_ps(scales_x + i);
+            _mm_storeu_ps(lefts + i, _mm_sub_ps(position, scale));
+            _mm_storeu_ps(rights + i, _mm_add_ps(position, scale));
+        }
+#endif
+        for (; i < count; i++) {
+            lefts[i] = positions_x[i] - scales_x[i];
+            rights[i] = positions_x[i] + scales_x[i];
+        }
+    }
+
+    // Index of the first unbroken brick in [first, end), skipping over broken ones 64 at a time (end if there is none):
+    u32 findAlive(u32 first, u32 end) const {
+        for (u32 word = first >> 6; (word << 6) < end; word++) {
+            u64 bits = alive[word];
+            if (word == first >> 6) bits &= ~0ULL << (first & 63);
+            if (bits) {
+                u32 i = (word << 6) + lowestBitIndex(bits);
+                return i < end ? i : end;
+            }
+        }
+        return end;
+    }
+};
+
+// A single brick of the storage, with the Brick API (reads and writes go straight through to the arrays):
+struct BrickView {
+    BrickArrays &bricks;
+    u32 index;
+
+    INLINE Rect rect() const { return bricks.getRect(index); }
+    INLINE vec2 position() const { return bricks.getPosition(index); }
+    INLINE f32 previous_position_x() const { return bricks.previous_positions_x[index]; }
+    INLINE f32 scale_x() const { return bricks.scales_x[index]; }
+    INLINE f32 speed_x() const { return bricks.speeds_x[index]; }
+    INLINE ColorID color_id() const { return bricks.color_ids[index]; }
+    INLINE char hits_to_break() const { return bricks.hits_to_break[index]; }
+
+    INLINE void hit() { bricks.hit(index); }
+    INLINE bool is_broken() const { return !bricks.isAlive(index); }
+    INLINE bool is_breakable() const { return bricks.isBreakable(index); }
+    INLINE bool is_movable() const { return bricks.isMovable(index); }
+
+    INLINE operator Brick() const { return bricks.get(index); }
+    INLINE BrickView& operator=(const Brick &brick) {
+        bricks.set(index, brick);
+        return *this;
+    }
+};
+
+INLINE BrickView BrickArrays::operator[](u32 i) { return {*this, i}; }
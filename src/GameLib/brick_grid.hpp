@@ -0,0 +1,123 @@
+#pragma once
+
+#include "./brick.hpp"
+
+// Uniform grid over a level's bricks (the broadphase for ball/brick collisions):
+// Rows match the level map's lines (bricks only ever slide horizontally), columns are a brick's width apart.
+// Each brick is linked into the one cell containing its center, and queries are expanded by the largest brick's
+// half-extents to make up for that. Bricks are relinked as they slide across columns and unlinked once broken,
+// so a query only ever visits the (few) cells around the area asked about, regardless of the bricks count.
+// The cells and per-brick links live in memory handed over by the level (sized to its map).
+struct BrickGrid {
+    static constexpr u32 NONE = 0xFFFFFFFF;
+
+    vec2 origin;     // Bottom-left corner of the first cell
+    vec2 cell_size;
+    vec2 max_half_extents{0};
+    u32 rows{0}, columns{0}, bricks_capacity{0};
+
+    // Intrusive doubly-linked list of bricks per cell:
+    u32 *cell_first_bricks{nullptr};
+    u32 *brick_cells{nullptr};
+    u32 *next_bricks{nullptr};
+    u32 *previous_bricks{nullptr};
+    u32 *candidates{nullptr}; // Results of the last query
+
+    static u64 getSizeInBytes(u32 row_count, u32 column_count, u32 bricks_count) {
+        return sizeof(u32) * ((u64)row_count * column_count + (u64)bricks_count * 4);
+    }
+
+    bool reset(const vec2 &grid_origin, const vec2 &grid_cell_size, u32 row_count, u32 column_count, u32 bricks_count,
+               memory::MonotonicAllocator &memory_allocator) {
+        origin = grid_origin;
+        cell_size = grid_cell_size;
+        max_half_extents = 0;
+        rows = columns = bricks_capacity = 0;
+
+        u32 cells_count = row_count * column_count;
+        cell_first_bricks = (u32*)memory_allocator.allocate(sizeof(u32) * cells_count);
+        brick_cells       = (u32*)memory_allocator.allocate(sizeof(u32) * bricks_count);
+        next_bricks       = (u32*)memory_allocator.allocate(sizeof(u32) * bricks_count);
+        previous_bricks   = (u32*)memory_allocator.allocate(sizeof(u32) * bricks_count);
+        candidates        = (u32*)memory_allocator.allocate(sizeof(u32) * bricks_count);
+        if (!cell_first_bricks || (bricks_count && !candidates)) return false;
+
+        rows = row_count;
+        columns = column_count;
+        bricks_capacity = bricks_count;
+        for (u32 i = 0; i < cells_count; i++) cell_first_bricks[i] = NONE;
+        for (u32 i = 0; i < bricks_count; i++) brick_cells[i] = NONE;
+        return true;
+    }
+
+    // Positions outside the grid are clamped into its border cells (so nothing is ever missed):
+    INLINE i32 getColumn(f32 x) const { return clampedValue((i32)floorf((x - origin.x) / cell_size.x), 0, (i32)columns - 1); }
+    INLINE i32 getRow(   f32 y) const { return clampedValue((i32)floorf((y - origin.y) / cell_size.y), 0, (i32)rows - 1); }
+    INLINE u32 getCell(const vec2 &position) const { return (u32)getRow(position.y) * columns + (u32)getColumn(position.x); }
+
+    void insert(u32 brick, const vec2 &position, f32 scale_x) {
+        if (brick >= bricks_capacity) return;
+        if (max_half_extents.x < scale_x) max_half_extents.x = scale_x;
+        if (max_half_extents.y < 1) max_half_extents.y = 1;
+        link(brick, getCell(position));
+    }
+
+    void remove(u32 brick) {
+        if (brick < bricks_capacity && brick_cells[brick] != NONE) unlink(brick);
+    }
+
+    // Relink a (slid) brick, only if it moved over to another cell:
+    INLINE void move(u32 brick, const vec2 &position) {
+        if (brick >= bricks_capacity || brick_cells[brick] == NONE) return;
+        u32 cell = getCell(position);
+        if (cell != brick_cells[brick]) {
+            unlink(brick);
+            link(brick, cell);
+        }
+    }
+
+    // Gather the bricks that may overlap a ball of the given radius anywhere along a path into the candidates,
+    // in ascending index order (the order a full scan would test them in, so hits resolve identically).
+    // Returns the candidates count:
+    u32 query(const vec2 &from, const vec2 &to, f32 radius) {
+        if (!rows || !columns) return 0;
+
+        f32 margin_x = radius + max_half_extents.x;
+        f32 margin_y = radius + max_half_extents.y;
+        i32 first_column = getColumn((from.x < to.x ? from.x : to.x) - margin_x);
+        i32 last_column  = getColumn((from.x < to.x ? to.x : from.x) + margin_x);
+        i32 first_row    = getRow(   (from.y < to.y ? from.y : to.y) - margin_y);
+        i32 last_row     = getRow(   (from.y < to.y ? to.y : from.y) + margin_y);
+
+        u32 count = 0;
+        for (i32 row = first_row; row <= last_row; row++)
+            for (i32 column = first_column; column <= last_column; column++)
+                for (u32 brick = cell_first_bricks[(u32)row * columns + (u32)column]; brick != NONE; brick = next_bricks[brick]) {
+                    // Insertion sort (there are only ever a handful of candidates):
+                    u32 i = count++;
+                    for (; i && candidates[i - 1] > brick; i--) candidates[i] = candidates[i - 1];
+                    candidates[i] = brick;
+                }
+
+        return count;
+    }
+
+private:
+    void link(u32 brick, u32 cell) {
+        u32 first = cell_first_bricks[cell];
+        if (first != NONE) previous_bricks[first] = brick;
+        next_bricks[brick] = first;
+        previous_bricks[brick] = NONE;
+        cell_first_bricks[cell] = brick;
+        brick_cells[brick] = cell;
+    }
+
+    void unlink(u32 brick) {
+        u32 next = next_bricks[brick];
+        u32 previous = previous_bricks[brick];
+        if (next != NONE) previous_bricks[next] = previous;
+        if (previous != NONE) next_bricks[previous] = next;
+        else cell_first_bricks[brick_cells[brick]] = next;
+        brick_cells[brick] = NONE;
+    }
+};
@@ -110,8 +110,7 @@ protected:
 
         ball_controller.update(delta_time,
                                current_level->scale, paddle,
-                               current_level->bricks,
-                               current_level->bricks_count);
+                               *current_level);
 
         current_level->updateBricks();
         if (!current_level->bricks_remaining)
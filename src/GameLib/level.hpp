@@ -1,6 +1,8 @@
 #pragma once
 
-#include "./brick.hpp"
+#include "./brick_arrays.hpp"
+#include "./brick_grid.hpp"
+#include "../SlimEngine/core/profiler.h"
 
 struct Level {
     static constexpr f32 DEFAULT_SCALE_X = 30;
@@ -18,24 +20,32 @@ struct Level {
     static constexpr char UNBREAKABLE_BRICK_CHAR = '#';
 
     char *map;
-    Brick *bricks;
+    BrickArrays bricks;
+    BrickGrid grid;
+
+    // Bricks of each row are consecutive (as parsed from the map), starting at their row's first brick index:
+    u32 *row_first_bricks{nullptr}; // One more than the rows count (the end of the last row)
+    u32 rows_count{0};
+
+    // Arena for the bricks and their grid, sized to the map when it's parsed (and reused by later resets).
+    // It is owned by the level (released when outgrown or when the level is destroyed), so levels are not copyable:
+    u8 *storage{nullptr};
+    u64 storage_capacity{0};
 
     vec2 scale;
     vec3 bounds_color;
     float top_padding;
     float side_padding;
     float bricks_padding;
-    u8 bricks_count;
-    u8 starting_bricks_remaining, bricks_remaining;
+    u32 starting_bricks_remaining, bricks_remaining;
 
-    Level(char *map, Brick *bricks,
+    Level(char *map,
           vec2 scale = {DEFAULT_SCALE_X, DEFAULT_SCALE_Y},
           ColorID bounds_color_id = DEFAULT_BOUNDS_COLOR,
           float bricks_padding = DEFAULT_BRICKS_PADDING,
           float top_padding = DEFAULT_TOP_PADDING,
           float side_padding = DEFAULT_SIDE_PADDING) :
         map{map},
-        bricks{bricks},
         scale{scale},
         bounds_color{Color(bounds_color_id)},
         top_padding{top_padding},
@@ -44,43 +54,90 @@ struct Level {
     {
         reset();
     }
+    Level(const Level &) = delete;
+    Level& operator=(const Level &) = delete;
+    ~Level() { release(); }
+
+    void release() {
+        if (storage) os::freeMemory(storage, storage_capacity);
+        storage = nullptr;
+        storage_capacity = 0;
+        row_first_bricks = nullptr;
+        bricks = {};
+        grid = {};
+        starting_bricks_remaining = bricks_remaining = rows_count = 0;
+    }
 
     void reset() {
         char *brick_char = map;
         float left = side_padding + Brick::DEFAULT_SCALE_X - scale.x;
         float top = scale.y * 2 - top_padding - 1;
         vec2 brick_position{left, top};
+        vec2 brick_pitch{Brick::DEFAULT_SCALE_X * 2 + bricks_padding, 2 + bricks_padding};
+
+        // Measure the map (its bricks, rows and longest row) to size the storage:
+        u32 map_bricks_count = 0;
+        u32 rows = 1, longest_row = 0, row_length = 0;
+        for (char *c = map; *c; c++) {
+            if (*c == '\n') {
+                rows++;
+                row_length = 0;
+                continue;
+            }
+            if (++row_length > longest_row) longest_row = row_length;
+            if (*c == UNBREAKABLE_BRICK_CHAR ||
+                *c == MOVING_BRICK_CHAR ||
+                *c == STRONG_BRICK_CHAR ||
+                *c == BRICK_CHAR) map_bricks_count++;
+        }
+
+        // The grid spans the level's width, or the map's if it is wider:
+        f32 grid_width = left + scale.x + brick_pitch.x * (f32)longest_row;
+        if (grid_width < scale.x * 2) grid_width = scale.x * 2;
+        u32 columns = (u32)ceilf(grid_width / brick_pitch.x);
+
+        u64 storage_size = BrickArrays::getSizeInBytes(map_bricks_count) +
+                           BrickGrid::getSizeInBytes(rows, columns, map_bricks_count) +
+                           sizeof(u32) * (rows + 1);
+        if (storage_size > storage_capacity) {
+            release();
+            storage = (u8*)os::getMemory(storage_size);
+            storage_capacity = storage ? storage_size : 0;
+        }
+        memory::MonotonicAllocator storage_allocator;
+        storage_allocator.address = storage;
+        storage_allocator.capacity = storage_capacity;
+        if (!bricks.allocate(map_bricks_count, storage_allocator) ||
+            !grid.reset({-scale.x, top - brick_pitch.y * 0.5f}, brick_pitch, rows, columns, map_bricks_count, storage_allocator) ||
+            !(row_first_bricks = (u32*)storage_allocator.allocate(sizeof(u32) * (rows + 1)))) {
+            starting_bricks_remaining = bricks_remaining = rows_count = 0;
+            return;
+        }
+        rows_count = rows;
+        row_first_bricks[0] = 0;
 
         starting_bricks_remaining = 0;
-        bricks_count = 0;
-        Brick *brick = bricks;
+        u32 row = 0;
         while (*brick_char) {
             switch (*brick_char) {
                 case UNBREAKABLE_BRICK_CHAR:
-                    *brick = Brick::Unbreakable(brick_position);
-                    brick++;
-                    bricks_count++;
+                    bricks.add(Brick::Unbreakable(brick_position));
                     break;
                 case MOVING_BRICK_CHAR:
-                    *brick = Brick::Moving(brick_position);
-                    brick++;
-                    bricks_count++;
+                    bricks.add(Brick::Moving(brick_position));
                     starting_bricks_remaining++;
                     break;
                 case STRONG_BRICK_CHAR:
-                    *brick = Brick::Strong(brick_position);
-                    brick++;
-                    bricks_count++;
+                    bricks.add(Brick::Strong(brick_position));
                     starting_bricks_remaining++;
                     break;
                 case BRICK_CHAR:
-                    *brick = Brick{brick_position};
-                    brick++;
-                    bricks_count++;
+                    bricks.add(Brick{brick_position});
                     starting_bricks_remaining++;
                     break;
             }
             if (*brick_char == '\n') {
+                row_first_bricks[++row] = bricks.count;
                 brick_position.x = left;
                 brick_position.y += 2 + bricks_padding;
             } else brick_position.x += Brick::DEFAULT_SCALE_X * 2 + bricks_padding;
@@ -88,52 +145,67 @@ struct Level {
             brick_char++;
         }
 
+        row_first_bricks[rows] = bricks.count;
+
+        for (u32 i = 0; i < bricks.count; i++) grid.insert(i, bricks.getPosition(i), bricks.scales_x[i]);
         bricks_remaining = starting_bricks_remaining;
     }
 
     void updateBricks() {
-        bricks_remaining = bricks_count;
-        for (u8 i = 0; i < bricks_count; i++) if (!bricks[i].is_breakable() || bricks[i].is_broken()) bricks_remaining--;
+        bricks_remaining = bricks.countRemaining();
     }
 
+    // Bricks only ever run into their neighbors within a row, and a row's bricks are sorted from left to right
+    // (sliding bricks bounce off each other before they could ever pass one another).
+    // So once all bricks have slid (vectorized), each row is swept just once: A moving brick bounces off its closest
+    // unbroken neighbor on the left (where it ended up) and then the one on its right (where it was before sliding),
+    // the same as if each brick was slid and then checked against every other brick in its row, in turn:
     void updateMovingBricks(float delta_time) {
-        for (u32 i = 0; i < bricks_count; i++) {
-            Brick &brick = bricks[i];
-            if (brick.is_movable()) {
-                brick.update(delta_time, scale.x, true);
-
-                // After moving the brick and handling collisions with the sides of the level,
-                // check also against other bricks and also flip direction on-hit:
-                for (u32 j = 0; j < bricks_count; j++) {
-                    if (j == i) continue;
-                    Brick &other_brick = bricks[j];
-                    if (other_brick.is_broken()) continue;
-                    if (brick.position.y != other_brick.position.y) continue;
-
-                    float gap = 0;
-                    if (
-                            brick.speed_x > 0 && // Sliding right
-                            brick.position.x < other_brick.position.x // Other brick is on the right
-                    ) gap = (
-                                (other_brick.position.x - other_brick.scale_x) // Left side of the other brick, right side of the gap
-                                -
-                                (brick.position.x + brick.scale_x) // Right side of the brick, left side of the gap
-                            );
-                    else if (
-                            brick.speed_x < 0 && // Sliding left
-                            other_brick.position.x < brick.position.x // Other brick is on the left
-                    ) gap = (
-                                (brick.position.x - brick.scale_x) // Left side of the brick, right side of the gap
-                                -
-                                (other_brick.position.x + other_brick.scale_x) // Right side of the other brick, left side of the gap
-                    );
-                    if (gap < 0) {
-                        brick.position.x += gap * (brick.speed_x > 0 ? 2.0f : -2.0f);
-                        brick.speed_x = -brick.speed_x;
-                    }
-                }
-                brick.updateRect();
+        PROFILE_ZONE("Level::updateMovingBricks");
+        bricks.slide(delta_time, scale.x);
+
+        for (u32 row = 0; row < rows_count; row++) {
+            u32 end = row_first_bricks[row + 1];
+            u32 left = end, right;
+            for (u32 i = bricks.findAlive(row_first_bricks[row], end); i < end; left = i, i = right) {
+                right = bricks.findAlive(i + 1, end);
+                if (!bricks.isMovable(i)) continue;
+
+                if (left != end) bounce(i, bricks.positions_x[left], bricks.scales_x[left]);
+                if (right != end) bounce(i, bricks.previous_positions_x[right], bricks.scales_x[right]);
             }
         }
+
+        bricks.updateRects();
+        for (u32 i = 0; i < bricks.count; i++) if (bricks.isMovable(i)) grid.move(i, bricks.getPosition(i));
+    }
+
+    // Flip a sliding brick's direction if it slid into another brick, pushing it back out by twice the overlap:
+    void bounce(u32 i, f32 other_position_x, f32 other_scale_x) {
+        f32 &position_x = bricks.positions_x[i];
+        f32 &speed_x = bricks.speeds_x[i];
+        f32 scale_x = bricks.scales_x[i];
+
+        float gap = 0;
+        if (
+                speed_x > 0 && // Sliding right
+                position_x < other_position_x // Other brick is on the right
+        ) gap = (
+                    (other_position_x - other_scale_x) // Left side of the other brick, right side of the gap
+                    -
+                    (position_x + scale_x) // Right side of the brick, left side of the gap
+                );
+        else if (
+                speed_x < 0 && // Sliding left
+                other_position_x < position_x // Other brick is on the left
+        ) gap = (
+                    (position_x - scale_x) // Left side of the brick, right side of the gap
+                    -
+                    (other_position_x + other_scale_x) // Right side of the other brick, left side of the gap
+        );
+        if (gap < 0) {
+            position_x += gap * (speed_x > 0 ? 2.0f : -2.0f);
+            speed_x = -speed_x;
+        }
     }
 };
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "../SlimEngine/core/base.h"
+
+// The game's shipped levels, in order (a line of the map per row of bricks, see Level for the brick characters):
+namespace GameMaps {
+    static char level01[] = ""
+                            "  ~  " "\n"
+                            "#= =#" "\n"
+                            "=~  =" "\n"
+                            "=---=";
+    static char level02[] = ""
+                            "     " "\n"
+                            "#-==*" "\n"
+                            "~  -=" "\n"
+                            "=~  =" "\n"
+                            "-=~ #";
+
+    static constexpr u8 levels_count = 2;
+}
@@ -57,7 +57,7 @@ struct PaddleController {
     {}
 
     void reset() {
-        paddle.position.x = start_position;
+        paddle.position.x = paddle.previous_position_x = start_position;
         paddle.speed_x = start_velocity;
         paddle.updateRect();
     }
@@ -0,0 +1,207 @@
+#pragma once
+
+#include "./game.hpp"
+#include "../SlimEngine/core/workers.h"
+
+// Headless batch simulation of many independent games (for tuning levels and the ball's launch parameters):
+// Every simulated game owns its Game and its own copies of the levels, and is stepped with a fixed delta time
+// by a script of timed key events and/or an autopilot that steers the paddle towards the ball.
+// The menus are never used (levels are started directly), so games share no mutable state at all and are simply
+// spread over the worker threads, a game per item. Each game is seeded by its index, so results are the same
+// for any thread count.
+#define SIMULATION_MAX_LEVEL_COUNT 16
+#define SIMULATION_DEFAULT__DELTA_TIME (1.0f / 240.0f)
+#define SIMULATION_DEFAULT__MAX_LEVEL_SECONDS 300.0f
+
+// A key event of a script, at a time (in seconds) since the current level started:
+struct SimulationInput {
+    f32 time;
+    u8 key;
+    bool is_pressed;
+};
+
+struct SimulationScript {
+    const SimulationInput *inputs{nullptr};
+    u32 inputs_count{0};
+    bool follow_ball{true};  // Steer the paddle towards the ball
+    bool auto_launch{true};  // Keep the launch key down (so the ball is launched whenever it comes in range)
+    f32 follow_dead_zone{1}; // Distance from the paddle's center within which the ball is not followed
+};
+
+struct SimulationSettings {
+    char **maps{nullptr};
+    u8 maps_count{0};
+    SimulationScript script{};
+    f32 delta_time{SIMULATION_DEFAULT__DELTA_TIME};
+    f32 max_level_seconds{SIMULATION_DEFAULT__MAX_LEVEL_SECONDS}; // A level still in play past this times out
+    u8 starting_lives{5};
+
+    // The ball's start velocity, with each game's horizontal component offset by up to the spread (at random):
+    vec2 ball_start_velocity{BallController::DEFAULT_START_VELOCITY_X, BallController::DEFAULT_START_VELOCITY_y};
+    f32 ball_start_velocity_spread{0};
+    f32 launch_speed{PaddleController::DEFAULT_LAUNCH_SPEED};
+    u64 seed{1};
+};
+
+enum class LevelOutcome : u8 {
+    NotReached = 0,
+    Completed,
+    Failed,
+    TimedOut
+};
+
+struct SimulationLevelResult {
+    LevelOutcome outcome{LevelOutcome::NotReached};
+    f32 seconds{0};
+    u8 lives_lost{0};
+    u32 bricks_remaining{0};
+};
+
+struct SimulatedGame {
+    Game game;
+    SimulationLevelResult level_results[SIMULATION_MAX_LEVEL_COUNT];
+    f64 game_seconds{0};
+    u64 steps_count{0};
+
+    SimulatedGame(Level *levels, u8 levels_count) : game{levels, levels_count} {}
+
+    // Deterministic per-game random number in [-1, 1] (SplitMix64 of the seed and the game's index):
+    static f32 getRandom(u64 seed, u32 index) {
+        u64 z = seed + 0x9E3779B97F4A7C15ULL * (index + 1);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z ^= z >> 31;
+        return (f32)((f64)(z >> 11) / (f64)(1ULL << 53) * 2.0 - 1.0);
+    }
+
+    // Play through the levels in order, until one is failed or times out (or they are all completed):
+    void play(const SimulationSettings &settings, u32 index) {
+        const SimulationScript &script = settings.script;
+        BallController &ball_controller = game.ball_controller;
+        PaddleController &paddle_controller = game.paddle_controller;
+        ball_controller.start_velocity = settings.ball_start_velocity;
+        ball_controller.start_velocity.x += settings.ball_start_velocity_spread * getRandom(settings.seed, index);
+        paddle_controller.launch_speed = settings.launch_speed;
+        game.starting_lives = settings.starting_lives;
+        game.startGame();
+
+        for (u8 level = 0; level < game.levels_count; level++) {
+            SimulationLevelResult &result = level_results[level];
+            u8 starting_lives = game.lives;
+            u32 next_input = 0;
+            f32 level_seconds = 0;
+            while (!game.current_menu && level_seconds < settings.max_level_seconds) {
+                for (; next_input < script.inputs_count && script.inputs[next_input].time <= level_seconds; next_input++)
+                    game.OnKeyChanged(script.inputs[next_input].key, script.inputs[next_input].is_pressed);
+                if (script.follow_ball) {
+                    f32 offset = game.ball.position.x - game.paddle.position.x;
+                    paddle_controller.move_right = offset > script.follow_dead_zone;
+                    paddle_controller.move_left = offset < -script.follow_dead_zone;
+                }
+                if (script.auto_launch) paddle_controller.launch_ball = true;
+
+                game.OnUpdate(settings.delta_time);
+                level_seconds += settings.delta_time;
+                steps_count++;
+            }
+            game_seconds += level_seconds;
+
+            result.seconds = level_seconds;
+            result.lives_lost = (u8)(starting_lives - game.lives);
+            result.bricks_remaining = game.current_level->bricks_remaining;
+            if (!game.current_menu) {
+                result.outcome = LevelOutcome::TimedOut;
+                return;
+            }
+            if (game.current_menu == &GameUI::level_failed_menu) {
+                result.outcome = LevelOutcome::Failed;
+                return;
+            }
+            result.outcome = LevelOutcome::Completed;
+            if (game.current_menu == &GameUI::end_menu) return;
+
+            game.startLevel(); // The game already moved on to the next level
+        }
+    }
+};
+
+struct SimulationLevelStatistics {
+    u32 reached_count{0}, completed_count{0}, failed_count{0}, timed_out_count{0};
+    f64 completed_seconds_sum{0};
+    f32 min_completed_seconds{0}, max_completed_seconds{0};
+    u64 completed_lives_lost_sum{0};
+    u64 failed_bricks_remaining_sum{0};
+};
+
+struct Simulation {
+    SimulationSettings settings;
+    SimulatedGame *games{nullptr};
+    Level *levels{nullptr}; // The levels of every game (maps_count per game)
+    u32 games_count{0};
+
+    SimulationLevelStatistics level_statistics[SIMULATION_MAX_LEVEL_COUNT];
+    f64 game_seconds{0};
+    u64 steps_count{0};
+
+    bool allocate(u32 count) {
+        if (settings.maps_count > SIMULATION_MAX_LEVEL_COUNT) settings.maps_count = SIMULATION_MAX_LEVEL_COUNT;
+        memory::MonotonicAllocator memory_allocator{(sizeof(SimulatedGame) + sizeof(Level) * settings.maps_count) * count};
+        games = (SimulatedGame*)memory_allocator.allocate(sizeof(SimulatedGame) * count);
+        levels = (Level*)memory_allocator.allocate(sizeof(Level) * settings.maps_count * count);
+        games_count = games && levels ? count : 0;
+        return games_count == count;
+    }
+
+    // Games are constructed by the thread that plays them (so is the memory of their levels):
+    static void playGames(void *data, u32 first_game, u32 end_game) {
+        Simulation &simulation = *(Simulation*)data;
+        const SimulationSettings &settings = simulation.settings;
+        for (u32 g = first_game; g < end_game; g++) {
+            Level *game_levels = simulation.levels + (u64)g * settings.maps_count;
+            for (u8 l = 0; l < settings.maps_count; l++) new(game_levels + l) Level{settings.maps[l]};
+            SimulatedGame *game = new(simulation.games + g) SimulatedGame{game_levels, settings.maps_count};
+            game->play(settings, g);
+
+            // Only the results are kept, so the levels (and their arenas) are released as soon as the game is over:
+            for (u8 l = 0; l < settings.maps_count; l++) game_levels[l].~Level();
+        }
+    }
+
+    void run() {
+        workers::run(playGames, this, games_count);
+
+        // Gather the statistics in order (independent of how games were spread over threads):
+        game_seconds = 0;
+        steps_count = 0;
+        for (SimulationLevelStatistics &statistics : level_statistics) statistics = {};
+        for (u32 g = 0; g < games_count; g++) {
+            const SimulatedGame &game = games[g];
+            game_seconds += game.game_seconds;
+            steps_count += game.steps_count;
+            for (u8 l = 0; l < settings.maps_count; l++) {
+                const SimulationLevelResult &result = game.level_results[l];
+                SimulationLevelStatistics &statistics = level_statistics[l];
+                switch (result.outcome) {
+                    case LevelOutcome::NotReached: continue;
+                    case LevelOutcome::Completed:
+                        if (!statistics.completed_count || result.seconds < statistics.min_completed_seconds)
+                            statistics.min_completed_seconds = result.seconds;
+                        if (!statistics.completed_count || result.seconds > statistics.max_completed_seconds)
+                            statistics.max_completed_seconds = result.seconds;
+                        statistics.completed_count++;
+                        statistics.completed_seconds_sum += result.seconds;
+                        statistics.completed_lives_lost_sum += result.lives_lost;
+                        break;
+                    case LevelOutcome::Failed:
+                        statistics.failed_count++;
+                        statistics.failed_bricks_remaining_sum += result.bricks_remaining;
+                        break;
+                    case LevelOutcome::TimedOut:
+                        statistics.timed_out_count++;
+                        break;
+                }
+                statistics.reached_count++;
+            }
+        }
+    }
+};
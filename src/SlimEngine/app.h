@@ -1,6 +1,8 @@
 #pragma once
 
 #include "./viewport/canvas.h"
+#include "./viewport/resolve.h"
+#include "./core/trace.h"
 //#include "./renderer/mesh_shaders.h"
 
 
@@ -12,55 +14,8 @@ namespace window {
     Canvas canvas{nullptr};
 
     void renderCanvasToContent() {
-        union RGBA2u32 {
-            u32 value;
-            RGBA rgba;
-
-            RGBA2u32() : value{0} {}
-        };
-        PixelQuad *src_pixel = canvas.pixels;
-        u32 *trg_value = content;
-        vec3 color;
-        RGBA2u32 background_pixel, trg_pixel;
-        background_pixel.rgba.R = (u8)(canvas.background.color.r * canvas.background.color.r * FLOAT_TO_COLOR_COMPONENT);
-        background_pixel.rgba.G = (u8)(canvas.background.color.g * canvas.background.color.g * FLOAT_TO_COLOR_COMPONENT);
-        background_pixel.rgba.B = (u8)(canvas.background.color.b * canvas.background.color.b * FLOAT_TO_COLOR_COMPONENT);
-        background_pixel.rgba.A = (u8)(canvas.background.opacity * canvas.background.opacity * FLOAT_TO_COLOR_COMPONENT);
-        if (canvas.antialias) {
-            for (u16 y = 0; y < canvas.dimensions.height; y++) {
-                for (u16 x = 0; x < canvas.dimensions.width; x++, src_pixel++, trg_value++) {
-                    if (src_pixel->TL.opacity != 0.0f ||
-                        src_pixel->TR.opacity != 0.0f ||
-                        src_pixel->BL.opacity != 0.0f ||
-                        src_pixel->BR.opacity != 0.0f) {
-                        color = src_pixel->TL.color * (src_pixel->TL.opacity * 0.25f);
-                        color = src_pixel->TR.color.scaleAdd(src_pixel->TR.opacity * 0.25f, color);
-                        color = src_pixel->BL.color.scaleAdd(src_pixel->BL.opacity * 0.25f, color);
-                        color = src_pixel->BR.color.scaleAdd(src_pixel->BR.opacity * 0.25f, color);
-                        trg_pixel.rgba.R = (u8)(color.r > 1.0f ? MAX_COLOR_VALUE : (FLOAT_TO_COLOR_COMPONENT * sqrt(color.r)));
-                        trg_pixel.rgba.G = (u8)(color.g > 1.0f ? MAX_COLOR_VALUE : (FLOAT_TO_COLOR_COMPONENT * sqrt(color.g)));
-                        trg_pixel.rgba.B = (u8)(color.b > 1.0f ? MAX_COLOR_VALUE : (FLOAT_TO_COLOR_COMPONENT * sqrt(color.b)));
-                        trg_pixel.rgba.A = (u8)(clampedValue(src_pixel->TL.opacity) * FLOAT_TO_COLOR_COMPONENT);
-                    } else trg_pixel = background_pixel;
-                    *trg_value = trg_pixel.value;
-                }
-            }
-        } else {
-            for (u16 y = 0; y < canvas.dimensions.height; y++) {
-                for (u16 x = 0; x < canvas.dimensions.width; x++, src_pixel++, trg_value++) {
-                    if (src_pixel->TL.depth == INFINITY)
-                        trg_pixel = background_pixel;
-                    else {
-                        color = src_pixel->TL.color * src_pixel->TL.opacity;
-                        trg_pixel.rgba.R = (u8)(color.r > 1.0f ? MAX_COLOR_VALUE : (FLOAT_TO_COLOR_COMPONENT * sqrt(color.r)));
-                        trg_pixel.rgba.G = (u8)(color.g > 1.0f ? MAX_COLOR_VALUE : (FLOAT_TO_COLOR_COMPONENT * sqrt(color.g)));
-                        trg_pixel.rgba.B = (u8)(color.b > 1.0f ? MAX_COLOR_VALUE : (FLOAT_TO_COLOR_COMPONENT * sqrt(color.b)));
-                        trg_pixel.rgba.A = (u8)(clampedValue(src_pixel->TL.opacity) * FLOAT_TO_COLOR_COMPONENT);
-                    }
-                    *trg_value = trg_pixel.value;
-                }
-            }
-        }
+        PROFILE_ZONE("renderCanvasToContent");
+        resolve::runAll(canvas, content);
     }
 }
 
@@ -80,16 +35,34 @@ struct SlimEngine {
     virtual void OnRender() {};
     virtual void OnUpdate(f32 delta_time) {};
     virtual void OnWindowRedraw() {
-        update_timer.beginFrame();
-        OnUpdate(update_timer.delta_time);
-        update_timer.endFrame();
+        {
+            PROFILE_ZONE("OnWindowRedraw");
+            update_timer.beginFrame();
+            {
+                PROFILE_ZONE("OnUpdate");
+                if (update_timer.fixed_steps_per_second) {
+                    for (u16 step = update_timer.accumulateFixedSteps(); step; step--)
+                        OnUpdate(update_timer.fixed_delta_time);
+                } else
+                    OnUpdate(update_timer.delta_time);
+            }
+            update_timer.endFrame();
 
-        window::canvas.clear();
-        render_timer.beginFrame();
-        OnRender();
-        render_timer.endFrame();
-        window::renderCanvasToContent();
-        mouse::resetChanges();
+            {
+                PROFILE_ZONE("Canvas::clear");
+                window::canvas.clear();
+            }
+            render_timer.beginFrame();
+            {
+                PROFILE_ZONE("OnRender");
+                OnRender();
+            }
+            render_timer.endFrame();
+            window::renderCanvasToContent();
+            mouse::resetChanges();
+        }
+        profiler::endFrame();
+        trace::write();
     };
 
     void resize(u16 width, u16 height) {
@@ -104,4 +77,8 @@ struct SlimEngine {
 
 SlimEngine* createEngine();
 
-#include "./platforms/win32.h"
\ No newline at end of file
+#ifdef _WIN32
+#include "./platforms/win32.h"
+#else
+#include "./platforms/posix.h"
+#endif
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #ifdef __cplusplus
 #include <cmath>
+#include <cstring>
+#include <new>
 #else
 #include <math.h>
 #endif
@@ -55,10 +57,10 @@ ENABLE_FP_CONTRACT
 
 typedef unsigned char      u8;
 typedef unsigned short     u16;
-typedef unsigned long int  u32;
+typedef unsigned int       u32;
 typedef unsigned long long u64;
 typedef signed   short     i16;
-typedef signed   long int  i32;
+typedef signed   int       i32;
 
 typedef float  f32;
 typedef double f64;
@@ -141,6 +143,13 @@ typedef void (*CallbackWithCharPtr)(char* str);
 #define VIEWPORT_DEFAULT__NEAR_CLIPPING_PLANE_DISTANCE 0.001f
 #define VIEWPORT_DEFAULT__FAR_CLIPPING_PLANE_DISTANCE 1000.0f
 
+#define TIMER_DEFAULT__MAX_STEPS_PER_FRAME 8
+#define TIMER_DEFAULT__BUDGET_MICROSECONDS 16667
+
+#define FRAME_HISTOGRAM_SUB_BUCKET_BITS 5
+#define FRAME_HISTOGRAM_SUB_BUCKET_COUNT (1 << FRAME_HISTOGRAM_SUB_BUCKET_BITS)
+#define FRAME_HISTOGRAM_BUCKET_COUNT ((32 - FRAME_HISTOGRAM_SUB_BUCKET_BITS + 1) * FRAME_HISTOGRAM_SUB_BUCKET_COUNT)
+
 //// Culling flags:
 //// ======================
 //#define IS_NEAR  0b00000001
@@ -217,6 +226,10 @@ INLINE f32 smoothStep(f32 from, f32 to, f32 t) {
     return t * t * (3.0f - 2.0f * t);
 }
 
+INLINE f32 lerp(f32 from, f32 to, f32 by) {
+    return fast_mul_add(to - from, by, from);
+}
+
 INLINE f32 approach(f32 src, f32 trg, f32 diff) {
     f32 out;
 
@@ -369,6 +382,7 @@ union RGBA {
 
     RGBA() : RGBA{0, 0, 0, MAX_COLOR_VALUE} {}
     RGBA(u8 r, u8 g, u8 b, u8 a) : B{b}, G{g}, R{r}, A{a} {}
+    explicit RGBA(u32 value) : value{value} {}
 
     RGBA(enum ColorID color_id) : RGBA{0, 0, 0, MAX_COLOR_VALUE} {
         switch (color_id) {
@@ -542,6 +556,7 @@ namespace controls {
 
 namespace os {
     void* getMemory(u64 size);
+    void freeMemory(void *address, u64 size);
     void setWindowTitle(char* str);
     void setWindowCapture(bool on);
     void setCursorVisibility(bool on);
@@ -550,6 +565,13 @@ namespace os {
     void* openFileForWriting(const char* file_path);
     bool readFromFile(void *out, unsigned long, void *handle);
     bool writeToFile(void *out, unsigned long, void *handle);
+
+    typedef void (*ThreadProcedure)(void *data);
+    u32 getProcessorCount();
+    bool startThread(ThreadProcedure procedure, void *data);
+    void* createSemaphore(u32 initial_count);
+    void signalSemaphore(void *semaphore, u32 count);
+    void waitForSemaphore(void *semaphore);
 }
 
 namespace time {
@@ -560,8 +582,175 @@ namespace time {
     f64 microseconds_per_tick;
     f64 nanoseconds_per_tick;
 
+    // HDR-style histogram of frame times in microseconds (constant-time recording into a fixed set of buckets):
+    // Values below 64us get exact buckets, and every power of 2 above that is split into 32 linear sub-buckets,
+    // so any recorded value is off by at most ~3% (reported values are the upper end of their bucket).
+    struct FrameHistogram {
+        u32 counts[FRAME_HISTOGRAM_BUCKET_COUNT]{};
+        u64 frame_count{0};
+        u64 over_budget_count{0};
+        u32 budget_microseconds{TIMER_DEFAULT__BUDGET_MICROSECONDS};
+        u32 max_microseconds{0};
+
+        // Summary (as of the last update()):
+        u32 p50_microseconds{0};
+        u32 p95_microseconds{0};
+        u32 p99_microseconds{0};
+
+        static INLINE u32 getBucket(u32 microseconds) {
+            if (microseconds < 2 * FRAME_HISTOGRAM_SUB_BUCKET_COUNT) return microseconds;
+
+            u32 most_significant_bit = 0;
+            u32 value = microseconds;
+            if (value >= 1u << 16) { value >>= 16; most_significant_bit += 16; }
+            if (value >= 1u <<  8) { value >>=  8; most_significant_bit +=  8; }
+            if (value >= 1u <<  4) { value >>=  4; most_significant_bit +=  4; }
+            if (value >= 1u <<  2) { value >>=  2; most_significant_bit +=  2; }
+            if (value >= 1u <<  1) {               most_significant_bit +=  1; }
+            u32 shift = most_significant_bit - FRAME_HISTOGRAM_SUB_BUCKET_BITS;
+            return shift * FRAME_HISTOGRAM_SUB_BUCKET_COUNT + (microseconds >> shift);
+        }
+
+        static INLINE u32 getBucketUpperBound(u32 bucket) {
+            if (bucket < 2 * FRAME_HISTOGRAM_SUB_BUCKET_COUNT) return bucket;
+
+            u32 shift = bucket / FRAME_HISTOGRAM_SUB_BUCKET_COUNT - 1;
+            u32 sub_bucket = bucket % FRAME_HISTOGRAM_SUB_BUCKET_COUNT + FRAME_HISTOGRAM_SUB_BUCKET_COUNT;
+            return (u32)((((u64)sub_bucket + 1) << shift) - 1);
+        }
+
+        INLINE void record(u64 ticks) {
+            f64 microseconds = (f64)ticks * microseconds_per_tick;
+            u32 value = microseconds < (f64)0xFFFFFFFFu ? (u32)microseconds : 0xFFFFFFFFu;
+            counts[getBucket(value)]++;
+            frame_count++;
+            if (value > budget_microseconds) over_budget_count++;
+            if (value > max_microseconds) max_microseconds = value;
+        }
+
+        // The smallest value that the given fraction (0 to 1) of recorded frames are at or below:
+        u32 getPercentile(f64 fraction) const {
+            if (!frame_count) return 0;
+
+            u64 target = (u64)(fraction * (f64)frame_count + 0.5);
+            if (target < 1) target = 1;
+            u64 count = 0;
+            for (u32 bucket = 0; bucket < FRAME_HISTOGRAM_BUCKET_COUNT; bucket++) {
+                count += counts[bucket];
+                if (count >= target) {
+                    u32 value = getBucketUpperBound(bucket);
+                    return value < max_microseconds ? value : max_microseconds;
+                }
+            }
+            return max_microseconds;
+        }
+
+        void update() {
+            p50_microseconds = getPercentile(0.50);
+            p95_microseconds = getPercentile(0.95);
+            p99_microseconds = getPercentile(0.99);
+        }
+
+        void reset() {
+            for (u32 &count : counts) count = 0;
+            frame_count = over_budget_count = 0;
+            max_microseconds = p50_microseconds = p95_microseconds = p99_microseconds = 0;
+        }
+
+        static u32 appendNumber(char *buffer, u32 length, u32 capacity, u64 number) {
+            char digits[20];
+            u32 digit_count = 0;
+            do {
+                digits[digit_count++] = (char)('0' + number % 10);
+                number /= 10;
+            } while (number);
+            while (digit_count && length < capacity) buffer[length++] = digits[--digit_count];
+            return length;
+        }
+
+        static u32 appendString(char *buffer, u32 length, u32 capacity, const char *str) {
+            while (*str && length < capacity) buffer[length++] = *str++;
+            return length;
+        }
+
+        // Milliseconds with 2 decimals:
+        static u32 appendMilliseconds(char *buffer, u32 length, u32 capacity, u32 microseconds) {
+            u32 hundredths = (microseconds + 5) / 10;
+            length = appendNumber(buffer, length, capacity, hundredths / 100);
+            length = appendString(buffer, length, capacity, hundredths % 100 < 10 ? ".0" : ".");
+            return appendNumber(buffer, length, capacity, hundredths % 100);
+        }
+
+        // A short line for showing live (e.g. on a HUD) with the p50/p95/p99/max milliseconds and the frames over budget,
+        // as in: "4.21/6.02/9.87/12.50 ms, 3 over"
+        u32 format(char *buffer, u32 buffer_size) {
+            if (!buffer_size) return 0;
+
+            update();
+            u32 capacity = buffer_size - 1;
+            u32 length = appendMilliseconds(buffer, 0, capacity, p50_microseconds);
+            length = appendString(buffer, length, capacity, "/");
+            length = appendMilliseconds(buffer, length, capacity, p95_microseconds);
+            length = appendString(buffer, length, capacity, "/");
+            length = appendMilliseconds(buffer, length, capacity, p99_microseconds);
+            length = appendString(buffer, length, capacity, "/");
+            length = appendMilliseconds(buffer, length, capacity, max_microseconds);
+            length = appendString(buffer, length, capacity, " ms, ");
+            length = appendNumber(buffer, length, capacity, over_budget_count);
+            length = appendString(buffer, length, capacity, " over");
+            buffer[length] = 0;
+            return length;
+        }
+
+        // The summary followed by every non-empty bucket, one per line as: "bucket <upper bound us> <count>"
+        u32 dump(char *buffer, u32 buffer_size) {
+            if (!buffer_size) return 0;
+
+            update();
+            u32 capacity = buffer_size - 1;
+            u32 length = appendString(buffer, 0, capacity, "frames ");
+            length = appendNumber(buffer, length, capacity, frame_count);
+            length = appendString(buffer, length, capacity, " p50_us ");
+            length = appendNumber(buffer, length, capacity, p50_microseconds);
+            length = appendString(buffer, length, capacity, " p95_us ");
+            length = appendNumber(buffer, length, capacity, p95_microseconds);
+            length = appendString(buffer, length, capacity, " p99_us ");
+            length = appendNumber(buffer, length, capacity, p99_microseconds);
+            length = appendString(buffer, length, capacity, " max_us ");
+            length = appendNumber(buffer, length, capacity, max_microseconds);
+            length = appendString(buffer, length, capacity, " budget_us ");
+            length = appendNumber(buffer, length, capacity, budget_microseconds);
+            length = appendString(buffer, length, capacity, " over_budget ");
+            length = appendNumber(buffer, length, capacity, over_budget_count);
+            length = appendString(buffer, length, capacity, "\n");
+            for (u32 bucket = 0; bucket < FRAME_HISTOGRAM_BUCKET_COUNT; bucket++) if (counts[bucket]) {
+                length = appendString(buffer, length, capacity, "bucket ");
+                length = appendNumber(buffer, length, capacity, getBucketUpperBound(bucket));
+                length = appendString(buffer, length, capacity, " ");
+                length = appendNumber(buffer, length, capacity, counts[bucket]);
+                length = appendString(buffer, length, capacity, "\n");
+            }
+            buffer[length] = 0;
+            return length;
+        }
+    };
+
     struct Timer {
         f32 delta_time{0};
+        FrameHistogram histogram; // Every frame's ticks (between beginFrame and endFrame)
+
+        // Fixed-step simulation (enabled when fixed_steps_per_second is non-zero):
+        // Frame delta times are accumulated and consumed in whole steps of fixed_delta_time,
+        // with the leftover fraction of a step exposed as the interpolation factor for rendering.
+        f64 accumulated_delta_time{0.0};
+        f32 fixed_delta_time{0};
+        f32 interpolation_factor{1};
+        u16 fixed_steps_per_second{0};
+        u16 max_steps_per_frame{TIMER_DEFAULT__MAX_STEPS_PER_FRAME};
+        u16 steps_in_frame{0};
+        u64 accumulated_step_count{0};
+        u64 dropped_step_count{0};
+        f32 average_steps_per_frame{0};
 
         u64 ticks_before{0};
         u64 ticks_after{0};
@@ -603,7 +792,35 @@ namespace time {
             average_milliseconds_per_frame = (u16) (average_ticks_per_frame * milliseconds_per_tick);
             average_microseconds_per_frame = (u16) (average_ticks_per_frame * microseconds_per_tick);
             average_nanoseconds_per_frame = (u16) (average_ticks_per_frame * nanoseconds_per_tick);
-            accumulated_ticks = accumulated_frame_count = 0;
+            average_steps_per_frame = (f32) accumulated_step_count / (f32) accumulated_frame_count;
+            accumulated_ticks = accumulated_frame_count = accumulated_step_count = 0;
+        }
+
+        void setFixedStepRate(u16 steps_per_second, u16 max_steps = TIMER_DEFAULT__MAX_STEPS_PER_FRAME) {
+            fixed_steps_per_second = steps_per_second;
+            fixed_delta_time = steps_per_second ? 1.0f / (f32)steps_per_second : 0.0f;
+            max_steps_per_frame = max_steps ? max_steps : 1;
+            accumulated_delta_time = 0.0;
+            interpolation_factor = 1;
+        }
+
+        // Consume the current frame's delta time in fixed steps, returning how many steps to simulate.
+        // Falling more than max_steps_per_frame behind drops the backlog instead of spiraling further behind.
+        INLINE u16 accumulateFixedSteps() {
+            accumulated_delta_time += (f64)delta_time;
+            steps_in_frame = 0;
+            while (accumulated_delta_time >= (f64)fixed_delta_time && steps_in_frame < max_steps_per_frame) {
+                accumulated_delta_time -= (f64)fixed_delta_time;
+                steps_in_frame++;
+            }
+            if (accumulated_delta_time >= (f64)fixed_delta_time) {
+                u64 backlog = (u64)(accumulated_delta_time / (f64)fixed_delta_time);
+                accumulated_delta_time -= (f64)backlog * (f64)fixed_delta_time;
+                dropped_step_count += backlog;
+            }
+            accumulated_step_count += steps_in_frame;
+            interpolation_factor = (f32)(accumulated_delta_time / (f64)fixed_delta_time);
+            return steps_in_frame;
         }
 
         INLINE void beginFrame() {
@@ -616,6 +833,7 @@ namespace time {
         INLINE void endFrame() {
             ticks_after = getTicks();
             accumulate();
+            histogram.record(ticks_diff);
             if (accumulated_ticks >= (ticks_per_second / 8))
                 average();
         }
@@ -710,6 +928,7 @@ namespace mouse {
 
 namespace os {
     void* getMemory(u64 size);
+    void freeMemory(void *address, u64 size);
     void setWindowTitle(char* str);
     void setWindowCapture(bool on);
     void setCursorVisibility(bool on);
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "./workers.h"
+
+// Hierarchical scoped profiler:
+// PROFILE_ZONE("name") times the rest of the enclosing scope with time::getTicks(), with zones nesting into a tree
+// (a zone's parent is whichever zone enclosed it when it was first entered).
+// Every thread records into its own buffers, so zones never contend: A ring of its most recent zone records
+// (for detailed inspection/export), and per-zone totals that get gathered once per frame (for breakdowns).
+// While disabled (the default) a zone costs a single branch.
+#define PROFILER_MAX_THREAD_COUNT (WORKERS_MAX_THREAD_COUNT + 1)
+#define PROFILER_MAX_ZONE_COUNT 64
+#define PROFILER_MAX_DEPTH 16
+#define PROFILER_RING_CAPACITY 4096
+
+#define PROFILER_CONCAT_(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_(a, b)
+#define PROFILE_ZONE(name) \
+    static ProfilerZoneInfo PROFILER_CONCAT(profiler_zone_info_, __LINE__){name, 0}; \
+    profiler::Zone PROFILER_CONCAT(profiler_zone_, __LINE__){PROFILER_CONCAT(profiler_zone_info_, __LINE__)}
+
+// Static per zone site (ids start at 1, 0 = not yet entered):
+struct ProfilerZoneInfo {
+    const char *name;
+    u32 id;
+};
+
+struct ProfilerRecord {
+    u64 begin_ticks, end_ticks;
+    u32 frame;
+    u16 zone_id;
+    u16 depth;
+};
+
+struct ProfilerThread {
+    ProfilerRecord records[PROFILER_RING_CAPACITY];
+    u64 record_count; // Total ever recorded (the ring holds the last PROFILER_RING_CAPACITY of them)
+    u64 zone_ticks[PROFILER_MAX_ZONE_COUNT];
+    u32 zone_calls[PROFILER_MAX_ZONE_COUNT];
+    u32 stack[PROFILER_MAX_DEPTH];
+    u32 depth;
+};
+
+namespace profiler {
+    bool enabled{false};
+    u32 frame{0};
+
+    const char *zone_names[PROFILER_MAX_ZONE_COUNT];
+    u32 zone_parents[PROFILER_MAX_ZONE_COUNT];
+    u32 zone_depths[PROFILER_MAX_ZONE_COUNT];
+    volatile u32 zone_count{1}; // Id 0 is reserved (ids past the maximum are ignored)
+
+    ProfilerThread threads[PROFILER_MAX_THREAD_COUNT];
+    volatile u32 thread_count{0};
+    thread_local ProfilerThread *current_thread{nullptr};
+
+    // Per-zone totals of the last frame, and running sums over frames since the last reset (for averages):
+    u64 frame_ticks[PROFILER_MAX_ZONE_COUNT];
+    u32 frame_calls[PROFILER_MAX_ZONE_COUNT];
+    u64 total_ticks[PROFILER_MAX_ZONE_COUNT];
+    u64 total_calls[PROFILER_MAX_ZONE_COUNT];
+    u32 total_frame_count{0};
+
+    INLINE u32 getThreadCount() {
+        return thread_count < PROFILER_MAX_THREAD_COUNT ? thread_count : PROFILER_MAX_THREAD_COUNT;
+    }
+
+    INLINE u32 getZoneCount() {
+        return zone_count < PROFILER_MAX_ZONE_COUNT ? zone_count : PROFILER_MAX_ZONE_COUNT;
+    }
+
+    ProfilerThread* getThread() {
+        if (!current_thread && thread_count < PROFILER_MAX_THREAD_COUNT) {
+            u32 index = ATOMIC_INCREMENT(&thread_count);
+            if (index < PROFILER_MAX_THREAD_COUNT)
+                current_thread = threads + index;
+        }
+        return current_thread;
+    }
+
+    // A site racing another thread to register may waste an id (which then never gets any calls).
+    // Zones entered at the root of a worker (running a job) nest under the zone the main thread is waiting in:
+    void registerZone(ProfilerZoneInfo &info, const ProfilerThread &thread) {
+        const ProfilerThread &parent_thread = thread.depth || &thread == threads ? thread : threads[0];
+        u32 id = ATOMIC_INCREMENT(&zone_count);
+        if (id < PROFILER_MAX_ZONE_COUNT) {
+            zone_names[id] = info.name;
+            zone_parents[id] = parent_thread.depth ? parent_thread.stack[parent_thread.depth - 1] : 0;
+            zone_depths[id] = parent_thread.depth;
+        } else
+            id = PROFILER_MAX_ZONE_COUNT;
+        ATOMIC_COMPARE_AND_SWAP(&info.id, 0u, id);
+    }
+
+    struct Zone {
+        ProfilerThread *thread{nullptr};
+        u64 begin_ticks;
+        u32 id;
+
+        INLINE Zone(ProfilerZoneInfo &info) { if (enabled) begin(info); }
+        INLINE ~Zone() { if (thread) end(); }
+
+        void begin(ProfilerZoneInfo &info) {
+            ProfilerThread *zone_thread = getThread();
+            if (!zone_thread || zone_thread->depth == PROFILER_MAX_DEPTH) return;
+            if (!info.id) registerZone(info, *zone_thread);
+            if (info.id == PROFILER_MAX_ZONE_COUNT) return;
+
+            thread = zone_thread;
+            id = info.id;
+            thread->stack[thread->depth++] = id;
+            begin_ticks = time::getTicks();
+        }
+
+        void end() {
+            u64 end_ticks = time::getTicks();
+            thread->depth--;
+            thread->zone_ticks[id] += end_ticks - begin_ticks;
+            thread->zone_calls[id]++;
+
+            ProfilerRecord &record = thread->records[thread->record_count++ & (PROFILER_RING_CAPACITY - 1)];
+            record.begin_ticks = begin_ticks;
+            record.end_ticks = end_ticks;
+            record.frame = frame;
+            record.zone_id = (u16)id;
+            record.depth = (u16)thread->depth;
+        }
+    };
+
+    // Gather every thread's zone totals into the frame's totals (called by the main thread between frames,
+    // when no worker is running jobs):
+    void endFrame() {
+        if (!enabled) return;
+
+        u32 zone_end = getZoneCount();
+        u32 threads_end = getThreadCount();
+        for (u32 zone = 1; zone < zone_end; zone++) {
+            frame_ticks[zone] = 0;
+            frame_calls[zone] = 0;
+            for (u32 t = 0; t < threads_end; t++) {
+                ProfilerThread &thread = threads[t];
+                frame_ticks[zone] += thread.zone_ticks[zone];
+                frame_calls[zone] += thread.zone_calls[zone];
+                thread.zone_ticks[zone] = 0;
+                thread.zone_calls[zone] = 0;
+            }
+            total_ticks[zone] += frame_ticks[zone];
+            total_calls[zone] += frame_calls[zone];
+        }
+        total_frame_count++;
+        frame++;
+    }
+
+    void resetTotals() {
+        for (u32 zone = 0; zone < PROFILER_MAX_ZONE_COUNT; zone++) total_ticks[zone] = total_calls[zone] = 0;
+        total_frame_count = 0;
+    }
+
+    void appendChildren(u32 parent, u32 *order, u32 &count) {
+        u32 zone_end = getZoneCount();
+        for (u32 zone = 1; zone < zone_end; zone++)
+            if (zone_parents[zone] == parent && zone_names[zone]) {
+                order[count++] = zone;
+                appendChildren(zone, order, count);
+            }
+    }
+
+    // Fill in the ids of all the zones in tree order (each zone followed by its children), returning their count:
+    u32 getZoneOrder(u32 *order) {
+        u32 count = 0;
+        appendChildren(0, order, count);
+        return count;
+    }
+}
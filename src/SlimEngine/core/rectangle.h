@@ -4,16 +4,12 @@
 
 struct Rect {
     union {
-        struct {
-            vec2 top_left;
-            vec2 bottom_right;
-        };
-        struct {
-            f32 left;
-            f32 top;
-            f32 right;
-            f32 bottom;
-        };
+        vec2 top_left;
+        struct { f32 left, top; };
+    };
+    union {
+        vec2 bottom_right;
+        struct { f32 right, bottom; };
     };
 
     Rect() : Rect{0, 0, 0, 0} {}
@@ -56,16 +52,12 @@ struct Rect {
 
 struct RectI {
     union {
-        struct {
-            vec2i top_left;
-            vec2i bottom_right;
-        };
-        struct {
-            i32 left;
-            i32 top;
-            i32 right;
-            i32 bottom;
-        };
+        vec2i top_left;
+        struct { i32 left, top; };
+    };
+    union {
+        vec2i bottom_right;
+        struct { i32 right, bottom; };
     };
 
     RectI() : RectI{0, 0, 0, 0} {}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "./profiler.h"
+
+// Chrome Trace Event export of the profiler's zones (loads in Perfetto, or chrome://tracing):
+// Once per frame (after the profiler gathered it) the zone records every thread added to its ring since the last write
+// are formatted as complete ("X") events, each carrying its begin timestamp and duration, on the recording thread's track.
+// Events go through a fixed size buffer that only hits the file when full, so memory stays bounded for any length
+// of session. Records a thread's ring overwrote before they got written (over PROFILER_RING_CAPACITY in a frame)
+// are skipped and counted as dropped.
+#define TRACE_BUFFER_SIZE (1 << 16)
+#define TRACE_MAX_EVENT_SIZE 512
+
+namespace trace {
+    void *file{nullptr};
+    char buffer[TRACE_BUFFER_SIZE];
+    u32 buffer_size{0};
+    u64 base_ticks{0};
+    u64 event_count{0};
+    u64 dropped_record_count{0};
+    u64 written_record_counts[PROFILER_MAX_THREAD_COUNT];
+    u32 named_thread_count{0};
+    bool failed{false};
+
+    void flushBuffer() {
+        if (buffer_size && !failed && !os::writeToFile(buffer, buffer_size, file))
+            failed = true;
+        buffer_size = 0;
+    }
+
+    INLINE void append(const char *str) {
+        while (*str) buffer[buffer_size++] = *str++;
+    }
+
+    INLINE void appendName(const char *name) {
+        for (u32 length = 0; *name && length < 128; name++, length++) {
+            if (*name == '"' || *name == '\\') buffer[buffer_size++] = '\\';
+            buffer[buffer_size++] = *name;
+        }
+    }
+
+    INLINE void appendNumber(u64 number) {
+        char digits[20];
+        u32 count = 0;
+        do {
+            digits[count++] = (char)('0' + number % 10);
+            number /= 10;
+        } while (number);
+        while (count) buffer[buffer_size++] = digits[--count];
+    }
+
+    // Microseconds with nanosecond precision (as trace timestamps are in microseconds):
+    INLINE void appendMicroseconds(u64 ticks) {
+        u64 nanoseconds = (u64)((f64)ticks * time::nanoseconds_per_tick);
+        appendNumber(nanoseconds / 1000);
+        u32 fraction = (u32)(nanoseconds % 1000);
+        buffer[buffer_size++] = '.';
+        buffer[buffer_size++] = (char)('0' + fraction / 100);
+        buffer[buffer_size++] = (char)('0' + fraction / 10 % 10);
+        buffer[buffer_size++] = (char)('0' + fraction % 10);
+    }
+
+    INLINE void beginEvent() {
+        if (buffer_size + TRACE_MAX_EVENT_SIZE > TRACE_BUFFER_SIZE) flushBuffer();
+        append(event_count++ ? ",\n" : "\n");
+    }
+
+    // The first thread to record is the one running the frames, the rest are workers:
+    void nameThreads() {
+        for (u32 end = profiler::getThreadCount(); named_thread_count < end; named_thread_count++) {
+            beginEvent();
+            append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":");
+            appendNumber(named_thread_count);
+            append(",\"args\":{\"name\":\"");
+            if (named_thread_count) {
+                append("Worker ");
+                appendNumber(named_thread_count);
+            } else
+                append("Main");
+            append("\"}}");
+        }
+    }
+
+    // Start a trace of the zones recorded from now on (enabling the profiler):
+    bool begin(const char *path) {
+        file = os::openFileForWriting(path);
+        if (!file) return false;
+
+        profiler::enabled = true;
+        base_ticks = time::getTicks();
+        event_count = dropped_record_count = 0;
+        buffer_size = named_thread_count = 0;
+        failed = false;
+        for (u32 t = 0; t < PROFILER_MAX_THREAD_COUNT; t++)
+            written_record_counts[t] = profiler::threads[t].record_count;
+
+        append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+        return true;
+    }
+
+    void write() {
+        if (!file) return;
+
+        nameThreads();
+        for (u32 t = 0, end = profiler::getThreadCount(); t < end; t++) {
+            const ProfilerThread &thread = profiler::threads[t];
+            u64 first = written_record_counts[t];
+            if (thread.record_count - first > PROFILER_RING_CAPACITY) {
+                dropped_record_count += thread.record_count - first - PROFILER_RING_CAPACITY;
+                first = thread.record_count - PROFILER_RING_CAPACITY;
+            }
+            for (u64 r = first; r < thread.record_count; r++) {
+                const ProfilerRecord &record = thread.records[r & (PROFILER_RING_CAPACITY - 1)];
+                if (record.begin_ticks < base_ticks) continue;
+
+                beginEvent();
+                append("{\"name\":\"");
+                appendName(profiler::zone_names[record.zone_id]);
+                append("\",\"ph\":\"X\",\"pid\":1,\"tid\":");
+                appendNumber(t);
+                append(",\"ts\":");
+                appendMicroseconds(record.begin_ticks - base_ticks);
+                append(",\"dur\":");
+                appendMicroseconds(record.end_ticks - record.begin_ticks);
+                append(",\"args\":{\"frame\":");
+                appendNumber(record.frame);
+                append("}}");
+            }
+            written_record_counts[t] = thread.record_count;
+        }
+    }
+
+    // Write any remaining events and close the trace (returns false if any write failed):
+    bool end() {
+        if (!file) return false;
+
+        write();
+        flushBuffer();
+        append("\n]}\n");
+        flushBuffer();
+        os::closeFile(file);
+        file = nullptr;
+        return !failed;
+    }
+}
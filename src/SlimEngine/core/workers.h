@@ -0,0 +1,101 @@
+#pragma once
+
+#include "./base.h"
+
+#define WORKERS_MAX_THREAD_COUNT 64
+#define WORKERS_DEFAULT__TASKS_PER_THREAD 4
+
+#ifdef COMPILER_MSVC
+#include <intrin.h>
+#define ATOMIC_INCREMENT(value) ((u32)_InterlockedIncrement((volatile long*)(value)) - 1)
+#define ATOMIC_DECREMENT(value) ((u32)_InterlockedDecrement((volatile long*)(value)))
+#define ATOMIC_COMPARE_AND_SWAP(value, expected, desired) ((u32)_InterlockedCompareExchange((volatile long*)(value), (long)(desired), (long)(expected)) == (u32)(expected))
+#else
+#define ATOMIC_INCREMENT(value) (__atomic_fetch_add((value), 1, __ATOMIC_ACQ_REL))
+#define ATOMIC_DECREMENT(value) (__atomic_sub_fetch((value), 1, __ATOMIC_ACQ_REL))
+#define ATOMIC_COMPARE_AND_SWAP(value, expected, desired) (__sync_bool_compare_and_swap((value), (expected), (desired)))
+#endif
+
+// A persistent pool of worker threads for splitting engine passes (clearing, resolving, etc.) into ranges.
+// The calling thread takes part in the work, so a thread count of 1 runs everything inline with no threading.
+// Jobs must only write to their own range, so results never depend on how many threads ran them.
+namespace workers {
+    typedef void (*Job)(void *data, u32 first_item, u32 end_item);
+
+    u32 thread_count{0}; // 0 = Not configured yet (defaults to the processor count on first use)
+    u32 started_thread_count{1};
+
+    void *work_semaphore{nullptr};
+    void *done_semaphore{nullptr};
+
+    Job current_job{nullptr};
+    void *current_data{nullptr};
+    u32 current_item_count{0};
+    u32 current_items_per_task{0};
+    u32 current_task_count{0};
+    volatile u32 next_task{0};
+    volatile u32 pending_worker_count{0};
+
+    void runTasks() {
+        for (u32 task = ATOMIC_INCREMENT(&next_task); task < current_task_count; task = ATOMIC_INCREMENT(&next_task)) {
+            u32 first_item = task * current_items_per_task;
+            u32 end_item = first_item + current_items_per_task;
+            current_job(current_data, first_item, end_item < current_item_count ? end_item : current_item_count);
+        }
+    }
+
+    void workerLoop(void *) {
+        while (true) {
+            os::waitForSemaphore(work_semaphore);
+            runTasks();
+            if (ATOMIC_DECREMENT(&pending_worker_count) == 0)
+                os::signalSemaphore(done_semaphore, 1);
+        }
+    }
+
+    // Threads are only ever added, lowering the count leaves the extra ones idle:
+    void setThreadCount(u32 count) {
+        if (count < 1) count = 1;
+        if (count > WORKERS_MAX_THREAD_COUNT) count = WORKERS_MAX_THREAD_COUNT;
+        if (count > started_thread_count) {
+            if (!work_semaphore) {
+                work_semaphore = os::createSemaphore(0);
+                done_semaphore = os::createSemaphore(0);
+                if (!work_semaphore || !done_semaphore) count = 1;
+            }
+            while (started_thread_count < count && os::startThread(workerLoop, nullptr))
+                started_thread_count++;
+            if (count > started_thread_count) count = started_thread_count;
+        }
+        thread_count = count;
+    }
+
+    // Run the job over the items [0, item_count), in tasks of at least min_items_per_task items:
+    void run(Job job, void *data, u32 item_count, u32 min_items_per_task = 1) {
+        if (!thread_count) setThreadCount(os::getProcessorCount());
+        if (!item_count) return;
+
+        u32 task_count = thread_count * WORKERS_DEFAULT__TASKS_PER_THREAD;
+        u32 items_per_task = (item_count + task_count - 1) / task_count;
+        if (items_per_task < min_items_per_task) items_per_task = min_items_per_task;
+        task_count = (item_count + items_per_task - 1) / items_per_task;
+
+        u32 worker_count = thread_count - 1;
+        if (worker_count > task_count - 1) worker_count = task_count - 1;
+        if (!worker_count) {
+            job(data, 0, item_count);
+            return;
+        }
+
+        current_job = job;
+        current_data = data;
+        current_item_count = item_count;
+        current_items_per_task = items_per_task;
+        current_task_count = task_count;
+        next_task = 0;
+        pending_worker_count = worker_count;
+        os::signalSemaphore(work_semaphore, worker_count);
+        runTasks();
+        os::waitForSemaphore(done_semaphore);
+    }
+}
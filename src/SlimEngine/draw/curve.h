@@ -2,86 +2,145 @@
 
 #include "../draw/edge.h"
 #include "../core/transform.h"
+#include "../core/profiler.h"
+#include "../scene/curve.h"
 #include "../viewport/viewport.h"
 
-#define CURVE_STEPS 360
+#define CURVE_LOD_DEFAULT__PIXEL_TOLERANCE 0.5f
+#define CURVE_LOD_MIN_STEP_COUNT 8
+
+// Screen-space level of detail for curves:
+// The step count is derived from the curve's projected size such that the polyline deviates from the
+// finely stepped curve by no more than the pixel tolerance. Step counts are picked from a fixed ladder
+// (steps of the square root of 2 below the requested count) to keep the number of cached variants small.
+namespace curve_lod {
+    bool enabled{false};
+    f32 pixel_tolerance{CURVE_LOD_DEFAULT__PIXEL_TOLERANCE};
+    u64 drawn_step_count{0};
+    u64 requested_step_count{0};
+}
+
+u32 getCurveStepCount(const Curve &curve, const Transform &transform, const Viewport &viewport, u32 max_step_count = CURVE_STEPS) {
+    const Camera &cam = *viewport.camera;
+    const Frustum &frustum = viewport.frustum;
+
+    // Screen-space bounds of the curve's transformed local bounds:
+    f32 extent = curve.type == CurveType::Coil ? 1 + curve.thickness : 1;
+    f32 height = curve.type == CurveType::Coil ? curve.thickness : 1;
+    f32 min_x = INFINITY, max_x = -INFINITY;
+    f32 min_y = INFINITY, max_y = -INFINITY;
+    vec3 corner;
+    for (u8 i = 0; i < 8; i++) {
+        corner.x = i & 1 ? extent : -extent;
+        corner.y = i & 2 ? height : -height;
+        corner.z = i & 4 ? extent : -extent;
+        corner = cam.internPos(transform.externPos(corner));
+        if (corner.z < frustum.near_clipping_plane_distance) return max_step_count; // Crosses the near plane
+
+        corner = frustum.projection.project(corner);
+        corner.x *= viewport.dimensions.h_width;
+        corner.y *= viewport.dimensions.h_height;
+        if (corner.x < min_x) min_x = corner.x;
+        if (corner.x > max_x) max_x = corner.x;
+        if (corner.y < min_y) min_y = corner.y;
+        if (corner.y > max_y) max_y = corner.y;
+    }
+    f32 radius = 0.5f * (max_x - min_x > max_y - min_y ? max_x - min_x : max_y - min_y);
+    if (viewport.canvas.antialias) radius *= 2; // Tolerance is in pixels but lines are drawn at sub-pixel resolution
+    if (radius <= 0) return CURVE_LOD_MIN_STEP_COUNT;
+
+    // A circle of radius r drawn with n segments deviates from it by r(1 - cos(pi/n)) ~= r * pi^2 / 2n^2:
+    f32 tolerance = curve_lod::pixel_tolerance > 0.01f ? curve_lod::pixel_tolerance : 0.01f;
+    f32 steps_per_revolution = (TAU * 0.5f) * sqrtf(radius / (2 * tolerance));
+    f32 steps = steps_per_revolution * curve.revolution_count;
+    if (curve.type == CurveType::Coil) {
+        f32 orbit_steps = steps_per_revolution * sqrtf(1.0f / (1 + curve.thickness));
+        f32 curve_steps = steps_per_revolution * sqrtf(curve.thickness / (1 + curve.thickness)) * curve.revolution_count;
+        steps = orbit_steps > curve_steps ? orbit_steps : curve_steps;
+    }
+
+    u32 step_count = max_step_count;
+    f32 next_step_count = (f32)max_step_count * SQRT2_OVER_2;
+    while (next_step_count >= steps + 1 && next_step_count >= CURVE_LOD_MIN_STEP_COUNT) {
+        step_count = (u32)next_step_count;
+        next_step_count *= SQRT2_OVER_2;
+    }
+    return step_count;
+}
 
 void draw(const Curve &curve, const Transform &transform, const Viewport &viewport,
           const vec3 &color = Color(White), f32 opacity = 1.0f, u8 line_width = 1, u32 step_count = CURVE_STEPS) {
+    PROFILE_ZONE("draw(Curve)");
     const Camera &cam = *viewport.camera;
+    curve_lod::requested_step_count += step_count;
+    if (curve_lod::enabled) step_count = getCurveStepCount(curve, transform, viewport, step_count);
+    curve_lod::drawn_step_count += step_count;
 
-    f32 one_over_step_count = 1.0f / (f32)step_count;
-    f32 rotation_step = one_over_step_count * TAU;
-    f32 rotation_step_times_rev_count = rotation_step * (f32)curve.revolution_count;
+    const CurveVertices &vertices = curve_cache::getVertices(curve, step_count);
 
-    if (curve.type == CurveType::Helix)
-        rotation_step = rotation_step_times_rev_count;
-
-    vec3 center_to_orbit;
-    center_to_orbit.x = 1;
-    center_to_orbit.y = center_to_orbit.z = 0;
-
-    vec3 orbit_to_curve;
-    orbit_to_curve.x = curve.thickness;
-    orbit_to_curve.y = orbit_to_curve.z = 0;
-
-    mat3 rotation;
-    rotation.X.x = rotation.Z.z = cosf(rotation_step);
-    rotation.X.z = sinf(rotation_step);
-    rotation.Z.x = -rotation.X.z;
-    rotation.X.y = rotation.Z.y = rotation.Y.x = rotation.Y.z =  0;
-    rotation.Y.y = 1;
-
-    mat3 orbit_to_curve_rotation;
-    if (curve.type == CurveType::Coil) {
-        orbit_to_curve_rotation.X.x = orbit_to_curve_rotation.Y.y = cosf(rotation_step_times_rev_count);
-        orbit_to_curve_rotation.X.y = sinf(rotation_step_times_rev_count);
-        orbit_to_curve_rotation.Y.x = -orbit_to_curve_rotation.X.y;
-        orbit_to_curve_rotation.X.z = orbit_to_curve_rotation.Y.z = orbit_to_curve_rotation.Z.x = orbit_to_curve_rotation.Z.y =  0;
-        orbit_to_curve_rotation.Z.z = 1;
-    }
-
-    // Transform vertices positions of edges from view-space to screen-space (w/ culling and clipping):
-    mat3 accumulated_orbit_rotation = rotation;
-    vec3 current_position, previous_position;
+    // Transform vertices positions of edges from local-space to view-space and draw them (w/ culling and clipping):
+    const vec3 *position = vertices.positions;
     Edge edge;
+    edge.to = cam.internPos(transform.externPos(*position));
+    for (u32 i = 1; i < vertices.step_count; i++) {
+        position++;
+        edge.from = edge.to;
+        edge.to   = cam.internPos(transform.externPos(*position));
+        draw(edge, viewport, color, opacity, line_width);
+    }
+}
+
+// Combined object-to-view transform of a curve instance (scale, rotation and translation followed by the
+// camera's inverse translation and rotation), so that each vertex only takes a single affine transformation:
+struct CurveInstanceTransform {
+    mat3 rotation_and_scale;
+    vec3 translation;
+
+    CurveInstanceTransform(const Transform &transform, const Camera &cam) {
+        mat3 unrotation = cam.rotation.transposed();
+        rotation_and_scale.X = unrotation * (transform.rotation * vec3{transform.scale.x, 0, 0});
+        rotation_and_scale.Y = unrotation * (transform.rotation * vec3{0, transform.scale.y, 0});
+        rotation_and_scale.Z = unrotation * (transform.rotation * vec3{0, 0, transform.scale.z});
+        translation = unrotation * (transform.position - cam.position);
+    }
 
-    for (u32 i = 0; i < step_count; i++) {
-        center_to_orbit = rotation * center_to_orbit;
-
-        switch (curve.type) {
-            case CurveType::Helix:
-                current_position = center_to_orbit;
-                current_position.y -= 1;
-                break;
-            case CurveType::Coil:
-                orbit_to_curve  = orbit_to_curve_rotation * orbit_to_curve;
-                current_position = accumulated_orbit_rotation * orbit_to_curve;
-                current_position += center_to_orbit;
-                break;
-            default:
-                break;
-        }
-
-        current_position = cam.internPos(transform.externPos(current_position));
-
-        if (i) {
-            edge.from = previous_position;
-            edge.to   = current_position;
-            draw(edge, viewport, color, opacity, line_width);
+    void apply(const vec3 *positions, vec3 *view_positions, u32 count) const {
+        const f32 xx = rotation_and_scale.X.x, xy = rotation_and_scale.X.y, xz = rotation_and_scale.X.z;
+        const f32 yx = rotation_and_scale.Y.x, yy = rotation_and_scale.Y.y, yz = rotation_and_scale.Y.z;
+        const f32 zx = rotation_and_scale.Z.x, zy = rotation_and_scale.Z.y, zz = rotation_and_scale.Z.z;
+        const f32 tx = translation.x, ty = translation.y, tz = translation.z;
+        for (u32 i = 0; i < count; i++) {
+            const f32 x = positions[i].x, y = positions[i].y, z = positions[i].z;
+            view_positions[i].x = xx*x + yx*y + zx*z + tx;
+            view_positions[i].y = xy*x + yy*y + zy*z + ty;
+            view_positions[i].z = xz*x + yz*y + zz*z + tz;
         }
-
-        switch (curve.type) {
-            case CurveType::Helix:
-                center_to_orbit.y += 2 * one_over_step_count;
-                break;
-            case CurveType::Coil:
-                accumulated_orbit_rotation *= rotation;
-                break;
-            default:
-                break;
+    }
+};
+
+// Draw many instances of the same curve (one per transform, optionally colored per instance):
+void draw(const Curve &curve, const Transform *transforms, u32 instance_count, const Viewport &viewport,
+          const vec3 *colors = nullptr, const vec3 &color = Color(White), f32 opacity = 1.0f, u8 line_width = 1,
+          u32 step_count = CURVE_STEPS) {
+    PROFILE_ZONE("draw(Curve) instanced");
+    static vec3 view_positions[CURVE_CACHE_MAX_STEP_COUNT];
+    const Camera &cam = *viewport.camera;
+    u32 instance_step_count;
+    Edge edge;
+    for (u32 instance = 0; instance < instance_count; instance++) {
+        const Transform &transform = transforms[instance];
+        instance_step_count = curve_lod::enabled ? getCurveStepCount(curve, transform, viewport, step_count) : step_count;
+        curve_lod::requested_step_count += step_count;
+        curve_lod::drawn_step_count += instance_step_count;
+
+        const CurveVertices &vertices = curve_cache::getVertices(curve, instance_step_count);
+        CurveInstanceTransform{transform, cam}.apply(vertices.positions, view_positions, vertices.step_count);
+
+        const vec3 &instance_color = colors ? colors[instance] : color;
+        for (u32 i = 1; i < vertices.step_count; i++) {
+            edge.from = view_positions[i - 1];
+            edge.to   = view_positions[i];
+            draw(edge, viewport, instance_color, opacity, line_width);
         }
-
-        previous_position = current_position;
     }
-}
\ No newline at end of file
+}
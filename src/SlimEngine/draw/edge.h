@@ -1,6 +1,6 @@
 #pragma once
 
-#include "./line.h"
+#include "./line_batch.h"
 #include "../viewport/viewport.h"
 
 
@@ -8,6 +8,17 @@ void draw(Edge edge, const Viewport &viewport, const vec3 &color = Color(White),
     if (!viewport.cullAndClipEdge(edge)) return;
 
     viewport.projectEdge(edge);
+    if (viewport.line_batch) {
+        viewport.line_batch->add(edge.from.x,
+                                 edge.from.y,
+                                 edge.from.z,
+                                 edge.to.x,
+                                 edge.to.y,
+                                 edge.to.z,
+                                 viewport, color, opacity, line_width);
+        return;
+    }
+
     drawLine(edge.from.x,
              edge.from.y,
              edge.from.z,
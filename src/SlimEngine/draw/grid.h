@@ -9,11 +9,13 @@ void draw(const Grid &grid, const Transform &transform, const Viewport &viewport
     static Grid view_space_grid;
 
     // Transform vertices positions from local-space to world-space and then to view-space:
-    for (u8 side = 0; side < 2; side++) {
-        for (u8 axis = 0; axis < 2; axis++) {
-            u8 segment_count = axis ? grid.v_segments : grid.u_segments;
-            for (u8 segment = 0; segment < segment_count; segment++)
-                view_space_grid.vertices.buffer[axis][side][segment] = (viewport.camera->internPos(transform.externPos(grid.vertices.buffer[axis][side][segment])));
+    for (u8 axis = 0; axis < 2; axis++) {
+        const GridAxisVertices &local_space_vertices = axis ? grid.vertices.v : grid.vertices.u;
+        GridAxisVertices &view_space_vertices = axis ? view_space_grid.vertices.v : view_space_grid.vertices.u;
+        u8 segment_count = axis ? grid.v_segments : grid.u_segments;
+        for (u8 segment = 0; segment < segment_count; segment++) {
+            view_space_vertices.from[segment] = viewport.camera->internPos(transform.externPos(local_space_vertices.from[segment]));
+            view_space_vertices.to[  segment] = viewport.camera->internPos(transform.externPos(local_space_vertices.to[  segment]));
         }
     }
 
@@ -4,6 +4,29 @@
 #include "../viewport/hud.h"
 #include "../viewport/viewport.h"
 
+// Retained HUD rendering:
+// The layer keeps every line's title and value composed into text stamps, re-composing one only when its text changes
+// (the value string, or switching to/from the alternate value). Each frame then just blits the cached spans,
+// with the current colors. Lines beyond the layer's capacity (or that can't be stamped) are drawn directly.
+#define HUD_LAYER_MAX_LINE_COUNT 16
+
+struct HUDLayerLine {
+    TextStamp title, value;
+};
+
+struct HUDLayer {
+    HUDLayerLine lines[HUD_LAYER_MAX_LINE_COUNT];
+    u32 composed_count{0}; // How many times a title or value got (re)composed
+
+    const TextStamp* update(TextStamp &stamp, char *text) {
+        if (!stamp.valid || strcmp(stamp.text, text)) {
+            composed_count++;
+            if (!stamp.build(text)) return nullptr;
+        }
+        return &stamp;
+    }
+};
+
 void draw(const HUD &hud, const Viewport &viewport) {
     u16 x = (u16)hud.position.x;
     u16 y = (u16)hud.position.y;
@@ -20,8 +43,15 @@ void draw(const HUD &hud, const Viewport &viewport) {
 
         char *text = alt ? line->alternate_value.char_ptr : line->value.string.char_ptr;
         vec3 color{Color(alt ? line->alternate_value_color : line->value_color)};
-        drawText(line->title.char_ptr, x, y, viewport, Color(line->title_color), 1);
-        drawText(text, x + (u16)line->title.length * FONT_WIDTH, y, viewport, color, 1);
+        u16 value_x = x + (u16)line->title.length * FONT_WIDTH;
+        if (hud.layer && i < HUD_LAYER_MAX_LINE_COUNT) {
+            HUDLayerLine &layer_line = hud.layer->lines[i];
+            drawText(hud.layer->update(layer_line.title, line->title.char_ptr), line->title.char_ptr, x, y, viewport, Color(line->title_color), 1);
+            drawText(hud.layer->update(layer_line.value, text), text, value_x, y, viewport, color, 1);
+        } else {
+            drawCachedText(line->title.char_ptr, x, y, viewport, Color(line->title_color), 1);
+            drawText(text, value_x, y, viewport, color, 1);
+        }
         y += (u16)(hud.settings.line_height * (f32)FONT_HEIGHT);
     }
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "../core/rectangle.h"
+#include "../core/profiler.h"
 #include "../viewport/viewport.h"
 
 void drawHLine(i32 x_start, i32 x_end, i32 y, const Viewport &viewport, const vec3 &color, f32 opacity = 1.0f) {
@@ -9,24 +11,9 @@ void drawHLine(i32 x_start, i32 x_end, i32 y, const Viewport &viewport, const ve
 
     if (!inRange(y, viewport.dimensions.height + viewport.position.y, viewport.position.y)) return;
 
-    i32 first, last, step = 1;
+    i32 first, last;
     subRange(x_start, x_end, viewport.dimensions.width + viewport.position.x, viewport.position.x, &first, &last);
-
-    Pixel pixel{color * color, opacity, 0};
-    if (viewport.canvas.antialias) {
-        y <<= 1;
-        first <<= 1;
-        last  <<= 1;
-        step = 2;
-        for (i32 x = first; x <= last; x += step) {
-            viewport.canvas.setPixel(x+0, y+0, pixel);
-            viewport.canvas.setPixel(x+1, y+0, pixel);
-            viewport.canvas.setPixel(x+0, y+1, pixel);
-            viewport.canvas.setPixel(x+1, y+1, pixel);
-        }
-    } else
-        for (i32 x = first; x <= last; x += step)
-            viewport.canvas.setPixel(x, y, pixel);
+    viewport.canvas.fillRect(first, last + 1, y, y + 1, Pixel{color * color, opacity, 0});
 }
 
 void drawVLine(i32 y_start, i32 y_end, i32 x, const Viewport &viewport, const vec3 &color, f32 opacity = 1.0f) {
@@ -35,66 +22,67 @@ void drawVLine(i32 y_start, i32 y_end, i32 x, const Viewport &viewport, const ve
     x       += viewport.position.x;
 
     if (!inRange(x, viewport.dimensions.width + viewport.position.x, viewport.position.x)) return;
-    i32 first, last, step = 1;
 
+    i32 first, last;
     subRange(y_start, y_end, viewport.dimensions.height + viewport.position.y, viewport.position.y, &first, &last);
-    Pixel pixel{color * color, opacity, 0};
-    if (viewport.canvas.antialias) {
-        x <<= 1;
-        first <<= 1;
-        last  <<= 1;
-        step = 2;
-        for (i32 y = first; y <= last; y += step) {
-            viewport.canvas.setPixel(x+0, y+0, pixel);
-            viewport.canvas.setPixel(x+1, y+0, pixel);
-            viewport.canvas.setPixel(x+0, y+1, pixel);
-            viewport.canvas.setPixel(x+1, y+1, pixel);
-        }
-    } else
-        for (i32 y = first; y <= last; y += step)
-            viewport.canvas.setPixel(x, y, pixel);
+    viewport.canvas.fillRect(x, x + 1, first, last + 1, Pixel{color * color, opacity, 0});
 }
 
-void drawLine(f32 x1, f32 y1, f64 z1,
-              f32 x2, f32 y2, f64 z2,
-              const Viewport &viewport,
-              vec3 color, f32 opacity, u8 line_width) {
-    if (x1 < 0 &&
-        y1 < 0 &&
-        x2 < 0 &&
-        y2 < 0)
-        return;
-
-    i32 x_left = viewport.position.x;
-    i32 y_top  = viewport.position.y;
-    x1 += (f32)x_left;
-    x2 += (f32)x_left;
-    y1 += (f32)y_top;
-    y2 += (f32)y_top;
+// Write one run of samples across a line (perpendicular to its major axis): An edge sample, line_width inner samples
+// and another edge sample. The run is clipped to the minor-axis bounds once, rather than checking every sample.
+// Inner samples of opaque lines without depth are stored directly, those of blended lines without depth are blended
+// directly, and anything else (including the edges, whose opacity may round up to 1) goes through the full check:
+template <CanvasStorage Storage, bool Antialias, bool Depth, bool Opaque, bool Shallow>
+INLINE void rasterizeLineRun(Canvas &canvas, i32 major, i32 minor, i32 minor_start, i32 minor_end,
+                             const vec3 &color, const Pixel &pixel, u32 packed_color,
+                             f32 first_opacity, f32 opacity, f32 last_opacity, f64 z, u8 line_width) {
+    i32 last = minor + line_width + 1;
+    if (inRange(minor, minor_end, minor_start)) {
+        if (Shallow) canvas.writeSample<Storage, Antialias>(major, minor, color, first_opacity, z);
+        else         canvas.writeSample<Storage, Antialias>(minor, major, color, first_opacity, z);
+    }
 
-    i32 w = viewport.dimensions.width + x_left;
-    i32 h = viewport.dimensions.height + y_top;
+    i32 first_inner = minor + 1 > minor_start ? minor + 1 : minor_start;
+    i32 end_inner = last < minor_end ? last : minor_end;
+    for (i32 m = first_inner; m < end_inner; m++) {
+        i32 x = Shallow ? major : m;
+        i32 y = Shallow ? m : major;
+        if (Opaque)      canvas.storeSample<Storage, Antialias>(x, y, pixel, packed_color);
+        else if (!Depth) canvas.blendSample<Storage, Antialias>(x, y, pixel);
+        else             canvas.writeSample<Storage, Antialias>(x, y, color, opacity, z);
+    }
 
-    color *= color;
-    i32 x, y;
-    if (viewport.canvas.antialias) {
-        x1 += x1;
-        x2 += x2;
-        y1 += y1;
-        y2 += y2;
-        w <<= 1;
-        h <<= 1;
-        line_width <<= 1;
-        line_width++;
+    if (inRange(last, minor_end, minor_start)) {
+        if (Shallow) canvas.writeSample<Storage, Antialias>(major, last, color, last_opacity, z);
+        else         canvas.writeSample<Storage, Antialias>(last, major, color, last_opacity, z);
     }
+}
+
+// Rasterize a line given in canvas (sub-pixel) coordinates, only touching samples within the given bounds.
+// Samples are computed the same way regardless of the bounds, so a line can be rasterized in separate parts.
+// Specialized at compile-time for the canvas storage and antialiasing, for whether the line has depth,
+// and for whether it is opaque (an opacity of 1 and no depth, so its inner samples can simply be stored).
+// Use getLineRasterizer() to pick the right variant:
+template <CanvasStorage Storage, bool Antialias, bool Depth, bool Opaque>
+void rasterizeLine(f32 x1, f32 y1, f64 z1,
+                   f32 x2, f32 y2, f64 z2,
+                   Canvas &canvas, const RectI &bounds,
+                   const vec3 &color, f32 opacity, u8 line_width) {
+    i32 x_left = bounds.left;
+    i32 y_top  = bounds.top;
+    i32 w = bounds.right;
+    i32 h = bounds.bottom;
+    i32 x, y, end_x, end_y;
     f64 tmp, z_range, range_remap;
     f32 dx = x2 - x1;
     f32 dy = y2 - y1;
     f32 gap, grad, first_offset, last_offset;
-    f64 z, z_curr, z_step;
+    f64 z = 0, z_curr = 0, z_step = 0;
     vec3 first, last;
     vec2i start, end;
-    bool has_depth = z1 != 0.0 || z2 != 0.0;
+
+    Pixel pixel{color, opacity, 0};
+    u32 packed_color = Opaque && Storage == CanvasStorage::Planes ? color.toRGBA(0).value : 0;
     if (fabsf(dx) > fabsf(dy)) { // Shallow:
         if (x2 < x1) { // Left to right:
             tmp = x2; x2 = x1; x1 = (f32)tmp;
@@ -117,39 +105,19 @@ void drawLine(f32 x1, f32 y1, f64 z1,
         end.x   = (i32)last.x;
         end.y   = (i32)last.y;
 
-        x = start.x;
-        y = start.y;
         gap = oneMinusFractionOf(x1 + 0.5f);
+        if (inRange(start.x, w, x_left))
+            rasterizeLineRun<Storage, Antialias, true, false, true>(
+                canvas, start.x, start.y, y_top, h, color, pixel, packed_color,
+                oneMinusFractionOf(first.y) * gap * opacity, opacity, fractionOf(first.y) * gap * opacity, z1, line_width);
 
-        if (inRange(x, w, x_left)) {
-            if (inRange(y, h, y_top)) viewport.canvas.setPixel(x, y, color, oneMinusFractionOf(first.y) * gap * opacity, z1);
-
-            for (u8 i = 0; i < line_width; i++) {
-                y++;
-                if (inRange(y, h, y_top)) viewport.canvas.setPixel(x, y, color, opacity, z1);
-            }
-
-            y++;
-            if (inRange(y, h, y_top)) viewport.canvas.setPixel(x, y, color, fractionOf(first.y) * gap * opacity, z1);
-        }
-
-        x = end.x;
-        y = end.y;
         gap = fractionOf(x2 + 0.5f);
+        if (inRange(end.x, w, x_left))
+            rasterizeLineRun<Storage, Antialias, true, false, true>(
+                canvas, end.x, end.y, y_top, h, color, pixel, packed_color,
+                oneMinusFractionOf(last.y) * gap * opacity, opacity, fractionOf(last.y) * gap * opacity, z2, line_width);
 
-        if (inRange(x, w, x_left)) {
-            if (inRange(y, h, y_top)) viewport.canvas.setPixel(x, y, color, oneMinusFractionOf(last.y) * gap * opacity, z2);
-
-            for (u8 i = 0; i < line_width; i++) {
-                y++;
-                if (inRange(y, h, y_top)) viewport.canvas.setPixel(x, y, color, opacity, z2);
-            }
-
-            y++;
-            if (inRange(y, h, y_top)) viewport.canvas.setPixel(x, y, color, fractionOf(last.y) * gap * opacity, z2);
-        }
-
-        if (has_depth) { // Compute one-over-depth start and step
+        if (Depth) { // Compute one-over-depth start and step
             z1 = 1.0 / z1;
             z2 = 1.0 / z2;
             z_range = z2 - z1;
@@ -159,26 +127,24 @@ void drawLine(f32 x1, f32 y1, f64 z1,
             z_range = z2 - z1;
             z_step = z_range / (f64)(last.x - first.x - 1);
             z_curr = z1;
-        } else z = 0;
+        }
 
+        // Columns left of the bounds are skipped, only accumulating the interpolants (keeping them exact):
         gap = first.y + grad;
-        for (x = start.x + 1; x < end.x; x++) {
-            if (inRange(x, w, x_left)) {
-                if (has_depth) z = 1.0 / z_curr;
-                y = (i32) gap;
-                if (inRange(y, h, y_top)) viewport.canvas.setPixel(x, y, color, oneMinusFractionOf(gap) * opacity, z);
-
-                for (u8 i = 0; i < line_width; i++) {
-                    y++;
-                    if (inRange(y, h, y_top)) viewport.canvas.setPixel(x, y, color, opacity, z);
-                }
-
-                y++;
-                if (inRange(y, h, y_top)) viewport.canvas.setPixel(x, y, color, fractionOf(gap) * opacity, z);
-            }
+        x = start.x + 1;
+        end_x = end.x < w ? end.x : w;
+        for (; x < end_x && x < x_left; x++) {
+            gap += grad;
+            if (Depth) z_curr += z_step;
+        }
+        for (; x < end_x; x++) {
+            if (Depth) z = 1.0 / z_curr;
+            rasterizeLineRun<Storage, Antialias, Depth, Opaque, true>(
+                canvas, x, (i32)gap, y_top, h, color, pixel, packed_color,
+                oneMinusFractionOf(gap) * opacity, opacity, fractionOf(gap) * opacity, z, line_width);
 
             gap += grad;
-            if (has_depth) z_curr += z_step;
+            if (Depth) z_curr += z_step;
         }
     } else { // Steep:
         if (y2 < y1) { // Bottom up:
@@ -192,7 +158,7 @@ void drawLine(f32 x1, f32 y1, f64 z1,
         first.y = roundf(y1);
         last.y  = roundf(y2);
 
-        first_offset = y1 - first.y;
+        first_offset = first.y - y1;
         last_offset  = last.y  - y2;
 
         first.x = x1 + grad * first_offset;
@@ -204,39 +170,19 @@ void drawLine(f32 x1, f32 y1, f64 z1,
         end.y = (i32)last.y;
         end.x = (i32)last.x;
 
-        x = start.x;
-        y = start.y;
         gap = oneMinusFractionOf(y1 + 0.5f);
+        if (inRange(start.y, h, y_top))
+            rasterizeLineRun<Storage, Antialias, true, false, false>(
+                canvas, start.y, start.x, x_left, w, color, pixel, packed_color,
+                oneMinusFractionOf(first.x) * gap * opacity, opacity, fractionOf(first.x) * gap * opacity, z1, line_width);
 
-        if (inRange(y, h, y_top)) {
-            if (inRange(x, w, x_left)) viewport.canvas.setPixel(x, y, color, oneMinusFractionOf(first.x) * gap * opacity, z1);
-
-            for (u8 i = 0; i < line_width; i++) {
-                x++;
-                if (inRange(x, w, x_left)) viewport.canvas.setPixel(x, y, color, opacity, z1);
-            }
-
-            x++;
-            if (inRange(x, w, x_left)) viewport.canvas.setPixel(x, y, color, fractionOf(first.x) * gap * opacity, z1);
-        }
-
-        x = end.x;
-        y = end.y;
         gap = fractionOf(y2 + 0.5f);
+        if (inRange(end.y, h, y_top))
+            rasterizeLineRun<Storage, Antialias, true, false, false>(
+                canvas, end.y, end.x, x_left, w, color, pixel, packed_color,
+                oneMinusFractionOf(last.x) * gap * opacity, opacity, fractionOf(last.x) * gap * opacity, z2, line_width);
 
-        if (inRange(y, h, y_top)) {
-            if (inRange(x, w, x_left)) viewport.canvas.setPixel(x, y, color, oneMinusFractionOf(last.x) * gap * opacity, z2);
-
-            for (u8 i = 0; i < line_width; i++) {
-                x++;
-                if (inRange(x, w, x_left)) viewport.canvas.setPixel(x, y, color, opacity, z2);
-            }
-
-            x++;
-            if (inRange(x, w, x_left)) viewport.canvas.setPixel(x, y, color, fractionOf(last.x) * gap * opacity, z2);
-        }
-
-        if (has_depth) { // Compute one-over-depth start and step
+        if (Depth) { // Compute one-over-depth start and step
             z1 = 1.0 / z1;
             z2 = 1.0 / z2;
             z_range = z2 - z1;
@@ -246,27 +192,140 @@ void drawLine(f32 x1, f32 y1, f64 z1,
             z_range = z2 - z1;
             z_step = z_range / (f64)(last.y - first.y - 1);
             z_curr = z1;
-        } else z = 0;
+        }
 
+        // Rows above the bounds are skipped, only accumulating the interpolants (keeping them exact):
         gap = first.x + grad;
-        for (y = start.y + 1; y < end.y; y++) {
-            if (inRange(y, h, y_top)) {
-                if (has_depth) z = 1.0 / z_curr;
-                x = (i32)gap;
+        y = start.y + 1;
+        end_y = end.y < h ? end.y : h;
+        for (; y < end_y && y < y_top; y++) {
+            gap += grad;
+            if (Depth) z_curr += z_step;
+        }
+        for (; y < end_y; y++) {
+            if (Depth) z = 1.0 / z_curr;
+            rasterizeLineRun<Storage, Antialias, Depth, Opaque, false>(
+                canvas, y, (i32)gap, x_left, w, color, pixel, packed_color,
+                oneMinusFractionOf(gap) * opacity, opacity, fractionOf(gap) * opacity, z, line_width);
 
-                if (inRange(x, w, x_left)) viewport.canvas.setPixel(x, y, color, oneMinusFractionOf(gap) * opacity, z);
+            gap += grad;
+            if (Depth) z_curr += z_step;
+        }
+    }
+}
 
-                for (u8 i = 0; i < line_width; i++) {
-                    x++;
-                    if (inRange(x, w, x_left)) viewport.canvas.setPixel(x, y, color, opacity, z);
-                }
+typedef void (*LineRasterizer)(f32 x1, f32 y1, f64 z1,
+                               f32 x2, f32 y2, f64 z2,
+                               Canvas &canvas, const RectI &bounds,
+                               const vec3 &color, f32 opacity, u8 line_width);
 
-                x++;
-                if (inRange(x, w, x_left)) viewport.canvas.setPixel(x, y, color, fractionOf(gap) * opacity, z);
-            }
+template <CanvasStorage Storage, bool Antialias>
+LineRasterizer getLineRasterizer(bool has_depth, bool is_opaque) {
+    if (has_depth) return rasterizeLine<Storage, Antialias, true, false>;
+    if (is_opaque) return rasterizeLine<Storage, Antialias, false, true>;
+    return rasterizeLine<Storage, Antialias, false, false>;
+}
 
-            gap += grad;
-            if (has_depth) z_curr += z_step;
+LineRasterizer getLineRasterizer(const Canvas &canvas, f64 z1, f64 z2, f32 opacity) {
+    bool has_depth = z1 != 0.0 || z2 != 0.0;
+    bool is_opaque = opacity == 1;
+    if (canvas.storage == CanvasStorage::Planes)
+        return canvas.antialias ?
+            getLineRasterizer<CanvasStorage::Planes, true >(has_depth, is_opaque) :
+            getLineRasterizer<CanvasStorage::Planes, false>(has_depth, is_opaque);
+    else
+        return canvas.antialias ?
+            getLineRasterizer<CanvasStorage::PixelQuads, true >(has_depth, is_opaque) :
+            getLineRasterizer<CanvasStorage::PixelQuads, false>(has_depth, is_opaque);
+}
+
+INLINE void rasterizeLine(f32 x1, f32 y1, f64 z1,
+                          f32 x2, f32 y2, f64 z2,
+                          Canvas &canvas, const RectI &bounds,
+                          const vec3 &color, f32 opacity, u8 line_width) {
+    getLineRasterizer(canvas, z1, z2, opacity)(x1, y1, z1, x2, y2, z2, canvas, bounds, color, opacity, line_width);
+}
+
+// Clip a line (in canvas sub-pixel coordinates) to the given bounds grown by a margin (Liang-Barsky).
+// The rasterizer fades the ends of a line, so the margin keeps any cut-off end outside of the bounds.
+// Depth is interpolated linearly in one-over-depth (as the rasterizer does), keeping trimmed ends perspective-correct.
+// Lines that are not cut are left untouched. Returns false when the line is entirely outside:
+bool clipLine(f32 &x1, f32 &y1, f64 &z1,
+              f32 &x2, f32 &y2, f64 &z2,
+              const RectI &bounds, f32 margin) {
+    f32 dx = x2 - x1;
+    f32 dy = y2 - y1;
+    f32 p[4] = {-dx, dx, -dy, dy};
+    f32 q[4] = {
+        x1 - ((f32)bounds.left - margin),
+        ((f32)(bounds.right - 1) + margin) - x1,
+        y1 - ((f32)bounds.top - margin),
+        ((f32)(bounds.bottom - 1) + margin) - y1
+    };
+    f32 t, t_enter = 0, t_exit = 1;
+    for (u8 i = 0; i < 4; i++) {
+        if (p[i] == 0) {
+            if (q[i] < 0) return false;
+        } else {
+            t = q[i] / p[i];
+            if (p[i] < 0) {
+                if (t > t_exit) return false;
+                if (t > t_enter) t_enter = t;
+            } else {
+                if (t < t_enter) return false;
+                if (t < t_exit) t_exit = t;
+            }
         }
     }
+    if (t_enter == 0 && t_exit == 1) return true;
+
+    if (z1 != 0.0 && z2 != 0.0) {
+        f64 one_over_z1 = 1.0 / z1;
+        f64 one_over_z_range = 1.0 / z2 - one_over_z1;
+        if (t_exit  < 1) z2 = 1.0 / (one_over_z1 + one_over_z_range * (f64)t_exit);
+        if (t_enter > 0) z1 = 1.0 / (one_over_z1 + one_over_z_range * (f64)t_enter);
+    }
+    if (t_exit < 1) {
+        x2 = x1 + dx * t_exit;
+        y2 = y1 + dy * t_exit;
+    }
+    if (t_enter > 0) {
+        x1 += dx * t_enter;
+        y1 += dy * t_enter;
+    }
+
+    return true;
+}
+
+void drawLine(f32 x1, f32 y1, f64 z1,
+              f32 x2, f32 y2, f64 z2,
+              const Viewport &viewport,
+              vec3 color, f32 opacity, u8 line_width) {
+    PROFILE_ZONE("drawLine");
+    i32 x_left = viewport.position.x;
+    i32 y_top  = viewport.position.y;
+    x1 += (f32)x_left;
+    x2 += (f32)x_left;
+    y1 += (f32)y_top;
+    y2 += (f32)y_top;
+
+    i32 w = viewport.dimensions.width + x_left;
+    i32 h = viewport.dimensions.height + y_top;
+
+    color *= color;
+    if (viewport.canvas.antialias) {
+        x1 += x1;
+        x2 += x2;
+        y1 += y1;
+        y2 += y2;
+        w <<= 1;
+        h <<= 1;
+        line_width <<= 1;
+        line_width++;
+    }
+
+    RectI bounds{x_left, w, y_top, h};
+    if (!clipLine(x1, y1, z1, x2, y2, z2, bounds, (f32)line_width + 2)) return;
+
+    rasterizeLine(x1, y1, z1, x2, y2, z2, viewport.canvas, bounds, color, opacity, line_width);
 }
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "./line.h"
+#include "../core/workers.h"
+
+// Deferred line rendering:
+// Lines are collected (already projected and in canvas sub-pixel coordinates) and binned into screen tiles.
+// On flush each tile rasterizes all of its lines together, in submission order, restricted to the tile's bounds.
+// That keeps the tile's pixels hot in cache, and as tiles never share pixels they can be rasterized in parallel.
+// The result is identical to drawing the lines immediately.
+#define LINE_BATCH_TILE_SHIFT 7
+#define LINE_BATCH_TILE_SIZE (1 << LINE_BATCH_TILE_SHIFT)
+#define LINE_BATCH_MAX_TILE_COLUMNS ((MAX_WIDTH  + LINE_BATCH_TILE_SIZE - 1) >> LINE_BATCH_TILE_SHIFT)
+#define LINE_BATCH_MAX_TILE_ROWS    ((MAX_HEIGHT + LINE_BATCH_TILE_SIZE - 1) >> LINE_BATCH_TILE_SHIFT)
+#define LINE_BATCH_MAX_TILE_COUNT (LINE_BATCH_MAX_TILE_COLUMNS * LINE_BATCH_MAX_TILE_ROWS)
+#define LINE_BATCH_CAPACITY (1 << 15)
+#define LINE_BATCH_MAX_TILE_REFERENCES (1 << 17)
+
+struct BatchedLine {
+    f64 z1, z2;
+    f32 x1, y1, x2, y2;
+    vec3 color;
+    f32 opacity;
+    RectI bounds;
+    RectI tiles;
+    LineRasterizer rasterize;
+    u8 line_width;
+};
+
+struct LineBatch {
+    BatchedLine lines[LINE_BATCH_CAPACITY];
+    u32 tile_lines[LINE_BATCH_MAX_TILE_REFERENCES];
+    u32 tile_offsets[LINE_BATCH_MAX_TILE_COUNT + 1];
+    u32 line_count{0};
+    u32 reference_count{0};
+    Canvas *canvas{nullptr};
+    u16 tile_columns{0};
+    u16 tile_rows{0};
+    u8 tile_shift{LINE_BATCH_TILE_SHIFT};
+
+    // Mirrors the setup of drawLine:
+    void add(f32 x1, f32 y1, f64 z1,
+             f32 x2, f32 y2, f64 z2,
+             const Viewport &viewport,
+             vec3 color, f32 opacity, u8 line_width) {
+        if (canvas != &viewport.canvas) {
+            flush();
+            canvas = &viewport.canvas;
+        }
+
+        i32 x_left = viewport.position.x;
+        i32 y_top  = viewport.position.y;
+        x1 += (f32)x_left;
+        x2 += (f32)x_left;
+        y1 += (f32)y_top;
+        y2 += (f32)y_top;
+
+        i32 w = viewport.dimensions.width + x_left;
+        i32 h = viewport.dimensions.height + y_top;
+
+        color *= color;
+        if (viewport.canvas.antialias) {
+            x1 += x1;
+            x2 += x2;
+            y1 += y1;
+            y2 += y2;
+            w <<= 1;
+            h <<= 1;
+            line_width <<= 1;
+            line_width++;
+        }
+
+        RectI bounds{x_left, w, y_top, h};
+        if (!clipLine(x1, y1, z1, x2, y2, z2, bounds, (f32)line_width + 2)) return;
+
+        // Conservative bounds of the samples the line can touch (the rasterizer rounds and extends by the width):
+        f32 margin = (f32)line_width + 3;
+        f32 min_x = (x1 < x2 ? x1 : x2) - 2, max_x = (x1 < x2 ? x2 : x1) + margin;
+        f32 min_y = (y1 < y2 ? y1 : y2) - 2, max_y = (y1 < y2 ? y2 : y1) + margin;
+        if (min_x > (f32)bounds.left)   bounds.left   = (i32)min_x;
+        if (min_y > (f32)bounds.top)    bounds.top    = (i32)min_y;
+        if (max_x < (f32)bounds.right)  bounds.right  = (i32)max_x + 1;
+        if (max_y < (f32)bounds.bottom) bounds.bottom = (i32)max_y + 1;
+        if (bounds.left >= bounds.right ||
+            bounds.top >= bounds.bottom)
+            return;
+
+        u8 shift = LINE_BATCH_TILE_SHIFT + (viewport.canvas.antialias ? 1 : 0);
+        RectI tiles{
+            bounds.left >> shift,
+            (bounds.right - 1) >> shift,
+            bounds.top >> shift,
+            (bounds.bottom - 1) >> shift
+        };
+        u32 tile_count = (u32)(tiles.right - tiles.left + 1) * (u32)(tiles.bottom - tiles.top + 1);
+        if (line_count == LINE_BATCH_CAPACITY ||
+            reference_count + tile_count > LINE_BATCH_MAX_TILE_REFERENCES)
+            flush();
+
+        BatchedLine &line = lines[line_count++];
+        line.x1 = x1;
+        line.y1 = y1;
+        line.z1 = z1;
+        line.x2 = x2;
+        line.y2 = y2;
+        line.z2 = z2;
+        line.color = color;
+        line.opacity = opacity;
+        line.line_width = line_width;
+        line.bounds = bounds;
+        line.tiles = tiles;
+        line.rasterize = getLineRasterizer(viewport.canvas, z1, z2, opacity);
+        reference_count += tile_count;
+    }
+
+    void flush() {
+        if (!line_count) return;
+        PROFILE_ZONE("LineBatch::flush");
+
+        tile_shift = LINE_BATCH_TILE_SHIFT + (canvas->antialias ? 1 : 0);
+        tile_columns = (u16)((canvas->dimensions.width  + LINE_BATCH_TILE_SIZE - 1) >> LINE_BATCH_TILE_SHIFT);
+        tile_rows    = (u16)((canvas->dimensions.height + LINE_BATCH_TILE_SIZE - 1) >> LINE_BATCH_TILE_SHIFT);
+        u32 tile_count = (u32)tile_columns * (u32)tile_rows;
+
+        // Bin the lines into tiles (counting, offsetting then filling, which keeps each tile's lines in order):
+        memset(tile_offsets, 0, sizeof(u32) * (tile_count + 1));
+        BatchedLine *line = lines;
+        for (u32 i = 0; i < line_count; i++, line++)
+            for (i32 row = line->tiles.top; row <= line->tiles.bottom; row++)
+                for (i32 column = line->tiles.left; column <= line->tiles.right; column++)
+                    tile_offsets[(u32)row * tile_columns + (u32)column + 1]++;
+
+        for (u32 tile = 0; tile < tile_count; tile++)
+            tile_offsets[tile + 1] += tile_offsets[tile];
+
+        line = lines;
+        for (u32 i = 0; i < line_count; i++, line++)
+            for (i32 row = line->tiles.top; row <= line->tiles.bottom; row++)
+                for (i32 column = line->tiles.left; column <= line->tiles.right; column++)
+                    tile_lines[tile_offsets[(u32)row * tile_columns + (u32)column]++] = i;
+
+        // Filling advanced each offset to the start of the next tile, so shift them back:
+        for (u32 tile = tile_count; tile; tile--)
+            tile_offsets[tile] = tile_offsets[tile - 1];
+        tile_offsets[0] = 0;
+
+        workers::run(rasterizeTiles, this, tile_count);
+
+        line_count = 0;
+        reference_count = 0;
+    }
+
+    static void rasterizeTiles(void *data, u32 first_tile, u32 end_tile) {
+        PROFILE_ZONE("LineBatch::rasterizeTiles");
+        LineBatch &batch = *(LineBatch*)data;
+        for (u32 tile = first_tile; tile < end_tile; tile++) {
+            if (batch.tile_offsets[tile] == batch.tile_offsets[tile + 1]) continue;
+
+            i32 left = (i32)(tile % batch.tile_columns) << batch.tile_shift;
+            i32 top  = (i32)(tile / batch.tile_columns) << batch.tile_shift;
+            i32 right  = left + (1 << batch.tile_shift);
+            i32 bottom = top  + (1 << batch.tile_shift);
+            for (u32 i = batch.tile_offsets[tile]; i < batch.tile_offsets[tile + 1]; i++) {
+                BatchedLine &line = batch.lines[batch.tile_lines[i]];
+                RectI bounds{
+                    line.bounds.left   > left   ? line.bounds.left   : left,
+                    line.bounds.right  < right  ? line.bounds.right  : right,
+                    line.bounds.top    > top    ? line.bounds.top    : top,
+                    line.bounds.bottom < bottom ? line.bounds.bottom : bottom
+                };
+                line.rasterize(line.x1, line.y1, line.z1,
+                               line.x2, line.y2, line.z2,
+                               *batch.canvas, bounds, line.color, line.opacity, line.line_width);
+            }
+        }
+    }
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "./hud.h"
+#include "../core/profiler.h"
+
+// On-screen breakdown of the profiled zones, drawn as a HUD (one line per zone, indented by its nesting depth):
+// Each line shows the zone's average microseconds per frame, re-averaged every refresh_frame_count frames
+// so that the numbers stay readable. When given the engine's timers, it first shows their frame time percentiles.
+#define PROFILER_OVERLAY_MAX_LINE_COUNT 16
+#define PROFILER_OVERLAY_TITLE_LENGTH 30
+#define PROFILER_OVERLAY_TIMER_TEXT_LENGTH 64
+#define PROFILER_OVERLAY_DEFAULT__REFRESH_FRAME_COUNT 30
+
+struct ProfilerOverlay {
+    HUDLine lines[PROFILER_OVERLAY_MAX_LINE_COUNT];
+    char titles[PROFILER_OVERLAY_MAX_LINE_COUNT][PROFILER_OVERLAY_TITLE_LENGTH + 1];
+    HUD hud{HUDSettings{}, lines, {10, 100}};
+    HUDLayer layer;
+    u32 refresh_frame_count{PROFILER_OVERLAY_DEFAULT__REFRESH_FRAME_COUNT};
+    ColorID title_color{BrightGrey};
+    ColorID value_color{BrightYellow};
+    char timer_texts[2][PROFILER_OVERLAY_TIMER_TEXT_LENGTH];
+    bool show_timer_texts{true};
+
+    ProfilerOverlay() { hud.layer = &layer; }
+
+    // Frame time percentiles of a timer, shown as the line's (alternate) text value:
+    void updateTimerLine(HUDLine &line, char *title, time::Timer &timer, char *text) {
+        timer.histogram.format(text, PROFILER_OVERLAY_TIMER_TEXT_LENGTH);
+        line.title = String{title};
+        line.title_color = title_color;
+        line.alternate_value = String{text};
+        line.alternate_value_color = value_color;
+        line.use_alternate = &show_timer_texts;
+    }
+
+    void update(time::Timer *update_timer = nullptr, time::Timer *render_timer = nullptr) {
+        if (profiler::total_frame_count < refresh_frame_count) return;
+
+        u32 line_count = 0;
+        if (update_timer) {
+            updateTimerLine(lines[line_count], (char*)"Update: ", *update_timer, timer_texts[line_count]);
+            line_count++;
+        }
+        if (render_timer) {
+            updateTimerLine(lines[line_count], (char*)"Render: ", *render_timer, timer_texts[line_count]);
+            line_count++;
+        }
+
+        u32 order[PROFILER_MAX_ZONE_COUNT];
+        u32 zone_count = profiler::getZoneOrder(order);
+        if (zone_count > PROFILER_OVERLAY_MAX_LINE_COUNT - line_count)
+            zone_count = PROFILER_OVERLAY_MAX_LINE_COUNT - line_count;
+
+        for (u32 i = 0; i < zone_count; i++, line_count++) {
+            u32 zone = order[i];
+            char *title = titles[line_count];
+            u32 length = 0;
+            for (u32 depth = 0; depth < profiler::zone_depths[zone] * 2 && length < PROFILER_OVERLAY_TITLE_LENGTH; depth++)
+                title[length++] = ' ';
+            for (const char *name = profiler::zone_names[zone]; *name && length < PROFILER_OVERLAY_TITLE_LENGTH - 1; name++)
+                title[length++] = *name;
+            while (length < PROFILER_OVERLAY_TITLE_LENGTH)
+                title[length++] = ' ';
+            title[length] = 0;
+
+            HUDLine &line = lines[line_count];
+            line.title = String{title, length};
+            line.use_alternate = nullptr;
+            line.title_color = title_color;
+            line.value_color = value_color;
+            line.value = (i32)((f64)profiler::total_ticks[zone] * time::microseconds_per_tick / (f64)profiler::total_frame_count);
+        }
+        hud.settings.line_count = line_count;
+        profiler::resetTotals();
+    }
+};
+
+void draw(ProfilerOverlay &overlay, const Viewport &viewport,
+          time::Timer *update_timer = nullptr, time::Timer *render_timer = nullptr) {
+    PROFILE_ZONE("draw(ProfilerOverlay)");
+    overlay.update(update_timer, render_timer);
+    if (overlay.hud.settings.line_count)
+        draw(overlay.hud, viewport);
+}
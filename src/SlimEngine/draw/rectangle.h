@@ -24,5 +24,7 @@ void fill(const RectI &RectI, const Viewport &viewport, const vec3 &color = Colo
     i32 min_x, min_y, max_x, max_y;
     subRange(RectI.left, RectI.right, viewport.dimensions.width,  0, &min_x, &max_x);
     subRange(RectI.bottom, RectI.top, viewport.dimensions.height, 0, &min_y, &max_y);
-    for (i32 y = min_y; y <= max_y; y++) drawHLine(min_x, max_x, y, viewport, color, opacity);
+    viewport.canvas.fillRect(min_x + viewport.position.x, max_x + viewport.position.x,
+                             min_y + viewport.position.y, max_y + viewport.position.y + 1,
+                             Pixel{color * color, opacity, 0});
 }
\ No newline at end of file
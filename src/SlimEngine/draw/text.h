@@ -109,11 +109,73 @@ u8 *char_addr[] = {bitmap_32,bitmap_33,bitmap_34,bitmap_35,bitmap_36,bitmap_37,b
 
 
 
+// The font pre-rasterized into horizontal spans of lit pixels (per glyph, ordered by row then column),
+// so text is drawn by filling whole spans rather than testing and setting every pixel of every glyph:
+#define GLYPH_COUNT (LAST_CHARACTER_CODE - FIRST_CHARACTER_CODE + 1)
+#define GLYPH_MAX_SPAN_COUNT (GLYPH_COUNT * FONT_HEIGHT * (FONT_WIDTH / 2 + 1))
+
+struct GlyphSpan {
+    u16 row, first_x, end_x;
+};
+
+namespace glyph_atlas {
+    GlyphSpan spans[GLYPH_MAX_SPAN_COUNT];
+    u16 first_span[GLYPH_COUNT + 1];
+    bool built{false};
+
+    // Glyph bitmaps are stored as 3 bands of 8-pixel columns (one byte per column, top bit at the bottom row):
+    INLINE bool isLit(const u8 *bitmap, u16 row, u16 column) {
+        u16 band = (row - 1) / (FONT_HEIGHT / 3);
+        u16 h = (band + 1) * (FONT_HEIGHT / 3) - row;
+        return (bitmap[band * FONT_WIDTH + column] & (0x80 >> h)) != 0;
+    }
+
+    void build() {
+        u32 span_count = 0;
+        for (u16 glyph = 0; glyph < GLYPH_COUNT; glyph++) {
+            first_span[glyph] = (u16)span_count;
+            const u8 *bitmap = char_addr[glyph];
+            for (u16 row = 1; row <= FONT_HEIGHT; row++)
+                for (u16 column = 0; column < FONT_WIDTH; column++) {
+                    if (!isLit(bitmap, row, column)) continue;
+
+                    GlyphSpan &span = spans[span_count++];
+                    span.row = row;
+                    span.first_x = column;
+                    while (column < FONT_WIDTH && isLit(bitmap, row, column)) column++;
+                    span.end_x = column;
+                }
+        }
+        first_span[GLYPH_COUNT] = (u16)span_count;
+        built = true;
+    }
+}
+
+// Fill spans (relative to the given position) with the pixel, skipping rows that fall below the canvas:
+// Opaque spans are written directly into the canvas rows (packing the pixel once), others are blended:
+void blitSpans(const GlyphSpan *spans, u32 span_count, i32 x, i32 y, Canvas &canvas, const Pixel &pixel) {
+    i32 end_y = canvas.dimensions.height;
+    const GlyphSpan *end = spans + span_count;
+    if (pixel.opacity == 1 && pixel.depth == 0) {
+        Canvas::FillJob job{&canvas, pixel};
+        for (const GlyphSpan *span = spans; span < end; span++)
+            if (y + span->row < end_y) {
+                canvas.markDrawnPixels(x + span->first_x, x + span->end_x, y + span->row, y + span->row + 1);
+                job.fillSpan(y + span->row, x + span->first_x, x + span->end_x);
+            }
+    } else
+        for (const GlyphSpan *span = spans; span < end; span++)
+            if (y + span->row < end_y)
+                canvas.fillRect(x + span->first_x, x + span->end_x, y + span->row, y + span->row + 1, pixel);
+}
+
 void drawText(char *str, i32 x, i32 y, const Viewport &viewport, const vec3 &color, f32 opacity) {
     if (x < 0 || x > viewport.dimensions.width  - FONT_WIDTH ||
         y < 0 || y > viewport.dimensions.height - FONT_HEIGHT)
         return;
 
+    if (!glyph_atlas::built) glyph_atlas::build();
+
     Pixel pixel{color, opacity, 0};
     pixel.color.r *= pixel.color.r;
     pixel.color.g *= pixel.color.g;
@@ -121,10 +183,7 @@ void drawText(char *str, i32 x, i32 y, const Viewport &viewport, const vec3 &col
 
     u16 current_x = (u16)x;
     u16 current_y = (u16)y;
-    u16 pixel_x, sub_pixel_x;
-    u16 pixel_y, sub_pixel_y;
-    u16 t_offset;
-    u8* byte;
+    u16 t_offset, glyph;
     char character = *str;
     while (character) {
         if (character == '\n') {
@@ -138,36 +197,142 @@ void drawText(char *str, i32 x, i32 y, const Viewport &viewport, const vec3 &col
             current_x += t_offset;
         } else if (character >= FIRST_CHARACTER_CODE &&
                    character <= LAST_CHARACTER_CODE) {
-            byte = char_addr[character - FIRST_CHARACTER_CODE];
-            for (int i = 1; i < 4; i++) {
-                pixel_x = current_x;
-                pixel_y = current_y + i * FONT_HEIGHT / 3;
-                for (int w = 0; w < FONT_WIDTH ; w++) {
-                    for (int h = 0; h < FONT_HEIGHT/3; h++) {
-                        /* skip background bits */
-                        if (*byte & (0x80  >> h)) {
-                            if (viewport.canvas.antialias) {
-                                sub_pixel_x = pixel_x << 1;
-                                sub_pixel_y = pixel_y << 1;
-                                viewport.canvas.setPixel(sub_pixel_x + 0, sub_pixel_y + 0, pixel);
-                                viewport.canvas.setPixel(sub_pixel_x + 1, sub_pixel_y + 0, pixel);
-                                viewport.canvas.setPixel(sub_pixel_x + 0, sub_pixel_y + 1, pixel);
-                                viewport.canvas.setPixel(sub_pixel_x + 1, sub_pixel_y + 1, pixel);
-                            } else
-                                viewport.canvas.setPixel(pixel_x, pixel_y, pixel);
+            glyph = character - FIRST_CHARACTER_CODE;
+            blitSpans(glyph_atlas::spans + glyph_atlas::first_span[glyph],
+                      glyph_atlas::first_span[glyph + 1] - glyph_atlas::first_span[glyph],
+                      current_x, current_y, viewport.canvas, pixel);
+            current_x += FONT_WIDTH;
+            if (current_x + FONT_WIDTH > viewport.dimensions.width)
+                return;
+        }
+        character = *++str;
+    }
+}
+
+// Pre-composed text: The spans of all the glyphs of a string laid out together (row by row, merging spans that
+// continue across neighbouring glyphs), so drawing a repeated string is a single pass over its spans.
+// Strings with tabs (whose layout depends on the absolute position) are not stamped.
+#define TEXT_STAMP_MAX_LENGTH 64
+#define TEXT_STAMP_MAX_SPAN_COUNT 1024
+#define TEXT_STAMP_CACHE_CAPACITY 16
+
+struct TextStamp {
+    char text[TEXT_STAMP_MAX_LENGTH]{};
+    GlyphSpan spans[TEXT_STAMP_MAX_SPAN_COUNT];
+    u32 span_count{0};
+    u32 last_used{0};
+    u16 width{0};       // Right-most glyph extent
+    u16 last_line_y{0}; // Offset of the last line
+    bool valid{false};
+
+    bool build(const char *str) {
+        valid = false;
+        span_count = 0;
+        width = last_line_y = 0;
+        u32 length = 0;
+        for (; str[length]; length++) if (length == TEXT_STAMP_MAX_LENGTH - 1 || str[length] == '\t') return false;
+        memcpy(text, str, length + 1);
+
+        if (!glyph_atlas::built) glyph_atlas::build();
+        const char *line = text;
+        while (true) {
+            const char *line_end = line;
+            while (*line_end && *line_end != '\n') line_end++;
+
+            u16 cursors[TEXT_STAMP_MAX_LENGTH];
+            for (const char *c = line; c < line_end; c++)
+                if (*c >= FIRST_CHARACTER_CODE && *c <= LAST_CHARACTER_CODE)
+                    cursors[c - line] = glyph_atlas::first_span[*c - FIRST_CHARACTER_CODE];
+
+            for (u16 row = 1; row <= FONT_HEIGHT; row++) {
+                u16 glyph_x = 0;
+                for (const char *c = line; c < line_end; c++) {
+                    if (*c < FIRST_CHARACTER_CODE || *c > LAST_CHARACTER_CODE) continue;
+
+                    u16 &cursor = cursors[c - line];
+                    u16 end = glyph_atlas::first_span[*c - FIRST_CHARACTER_CODE + 1];
+                    for (; cursor < end && glyph_atlas::spans[cursor].row == row; cursor++) {
+                        const GlyphSpan &glyph_span = glyph_atlas::spans[cursor];
+                        GlyphSpan *last = span_count ? spans + span_count - 1 : nullptr;
+                        if (last && last->row == last_line_y + row && last->end_x == glyph_x + glyph_span.first_x) {
+                            last->end_x = glyph_x + glyph_span.end_x;
+                            continue;
                         }
+                        if (span_count == TEXT_STAMP_MAX_SPAN_COUNT) return false;
 
-                        pixel_y--;
+                        GlyphSpan &span = spans[span_count++];
+                        span.row = last_line_y + row;
+                        span.first_x = glyph_x + glyph_span.first_x;
+                        span.end_x = glyph_x + glyph_span.end_x;
                     }
-                    byte++;
-                    pixel_y += FONT_HEIGHT / 3;
-                    pixel_x++;
+                    glyph_x += FONT_WIDTH;
                 }
+                if (glyph_x > width) width = glyph_x;
             }
-            current_x += FONT_WIDTH;
-            if (current_x + FONT_WIDTH > viewport.dimensions.width)
-                return;
+
+            if (!*line_end) break;
+            line = line_end + 1;
+            last_line_y += LINE_HEIGHT;
         }
-        character = *++str;
+
+        valid = true;
+        return true;
+    }
+
+    // Whether drawText would lay the string out the same way at this position (not cut off at the viewport's edges):
+    INLINE bool fits(i32 x, i32 y, const Viewport &viewport) const {
+        return x + width + FONT_WIDTH <= viewport.dimensions.width &&
+               y + last_line_y + FONT_HEIGHT <= viewport.dimensions.height;
+    }
+};
+
+// A fixed set of stamps keyed by their text, the least recently used one getting rebuilt when full:
+namespace text_stamps {
+    TextStamp entries[TEXT_STAMP_CACHE_CAPACITY];
+    u32 use_count{0};
+    u32 built_count{0};
+
+    const TextStamp* get(const char *str) {
+        TextStamp *least_recently_used = entries;
+        for (TextStamp &entry : entries) {
+            if (entry.valid && !strcmp(entry.text, str)) {
+                entry.last_used = ++use_count;
+                return &entry;
+            }
+            if (entry.last_used < least_recently_used->last_used)
+                least_recently_used = &entry;
+        }
+
+        TextStamp &entry = *least_recently_used;
+        entry.last_used = ++use_count;
+        built_count++;
+        return entry.build(str) ? &entry : nullptr;
+    }
+}
+
+// Draw text through a stamp of it, falling back to drawText when there's no stamp or it would be laid out differently:
+void drawText(const TextStamp *stamp, char *str, i32 x, i32 y, const Viewport &viewport, const vec3 &color, f32 opacity) {
+    if (x < 0 || x > viewport.dimensions.width  - FONT_WIDTH ||
+        y < 0 || y > viewport.dimensions.height - FONT_HEIGHT)
+        return;
+
+    if (!stamp || !stamp->valid || !stamp->fits(x, y, viewport)) {
+        drawText(str, x, y, viewport, color, opacity);
+        return;
     }
-}
\ No newline at end of file
+
+    Pixel pixel{color, opacity, 0};
+    pixel.color.r *= pixel.color.r;
+    pixel.color.g *= pixel.color.g;
+    pixel.color.b *= pixel.color.b;
+    blitSpans(stamp->spans, stamp->span_count, x, y, viewport.canvas, pixel);
+}
+
+// Draw repeated text (titles, labels, etc.) through the stamp cache:
+void drawCachedText(char *str, i32 x, i32 y, const Viewport &viewport, const vec3 &color, f32 opacity) {
+    if (x < 0 || x > viewport.dimensions.width  - FONT_WIDTH ||
+        y < 0 || y > viewport.dimensions.height - FONT_HEIGHT)
+        return;
+
+    drawText(text_stamps::get(str), str, x, y, viewport, color, opacity);
+}
@@ -3,12 +3,8 @@
 #include "./vec2.h"
 
 struct mat2 {
-    union {
-        f32 components[4];
-        vec2 axis[2];
-        struct { vec2 X, Y; };
-        struct { vec2 right, up; };
-    };
+    union { vec2 X, right; };
+    union { vec2 Y, up; };
 
     static mat2 Identity;
 
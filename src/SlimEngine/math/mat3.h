@@ -3,12 +3,9 @@
 #include "./vec3.h"
 
 struct mat3 {
-    union {
-        f32 components[9];
-        vec3 axis[3];
-        struct { vec3 X, Y, Z; };
-        struct { vec3 right, up, forward; };
-    };
+    union { vec3 X, right; };
+    union { vec3 Y, up; };
+    union { vec3 Z, forward; };
 
     static mat3 Identity;
 
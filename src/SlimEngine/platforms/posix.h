@@ -0,0 +1,317 @@
+// <time.h> declares a global time() function that would collide with the engine's time namespace,
+// so it is included under an alias (any later system header that includes it gets the guarded no-op):
+#define time posix_time
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <semaphore.h>
+#undef time
+
+// Headless platform layer:
+// There is no display and no input devices, the engine is driven for a fixed number of frames
+// rendering into window::content, which makes it suitable for offscreen throughput measurement.
+
+#define POSIX_VK_SPACE   0x20
+#define POSIX_VK_LEFT    0x25
+#define POSIX_VK_UP      0x26
+#define POSIX_VK_RIGHT   0x27
+#define POSIX_VK_DOWN    0x28
+#define POSIX_VK_SHIFT   0x10
+#define POSIX_VK_CONTROL 0x11
+#define POSIX_VK_MENU    0x12
+#define POSIX_VK_TAB     0x09
+#define POSIX_VK_ESCAPE  0x1B
+
+#define HEADLESS_DEFAULT__FRAME_COUNT 1000
+
+// File handles are file descriptors offset by one, so that a null handle always means failure:
+#define FD_TO_HANDLE(fd) ((void*)(long)((fd) + 1))
+#define HANDLE_TO_FD(handle) ((int)(long)(handle) - 1)
+
+void os::setWindowTitle(char* str) {
+    window::title = str;
+}
+
+void os::setCursorVisibility(bool) {}
+void os::setWindowCapture(bool) {}
+
+u64 time::getTicks() {
+    timespec now; // Local, as ticks get read from worker threads too (by profiler zones)
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000ULL + (u64)now.tv_nsec;
+}
+
+void* os::getMemory(u64 size) {
+    void *address = mmap((void*)MEMORY_BASE, (size_t)size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    return address == MAP_FAILED ? nullptr : address;
+}
+
+void os::freeMemory(void *address, u64 size) {
+    munmap(address, (size_t)size);
+}
+
+void os::closeFile(void *handle) {
+    close(HANDLE_TO_FD(handle));
+}
+
+void* os::openFileForReading(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+#ifndef NDEBUG
+        perror("open");
+        printf("Terminal failure: unable to open file \"%s\" for read.\n", path);
+#endif
+        return nullptr;
+    }
+    return FD_TO_HANDLE(fd);
+}
+
+void* os::openFileForWriting(const char* path) {
+    int fd = open(path, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+    if (fd == -1) {
+#ifndef NDEBUG
+        perror("open");
+        printf("Terminal failure: unable to open file \"%s\" for write.\n", path);
+#endif
+        return nullptr;
+    }
+    return FD_TO_HANDLE(fd);
+}
+
+bool os::readFromFile(void *out, unsigned long size, void *handle) {
+    int fd = HANDLE_TO_FD(handle);
+    u8 *bytes = (u8*)out;
+    while (size) {
+        ssize_t bytes_read = read(fd, bytes, size);
+        if (bytes_read <= 0) {
+#ifndef NDEBUG
+            perror("read");
+            printf("Terminal failure: Unable to read from file.\n");
+#endif
+            close(fd);
+            return false;
+        }
+        bytes += bytes_read;
+        size -= (unsigned long)bytes_read;
+    }
+    return true;
+}
+
+bool os::writeToFile(void *out, unsigned long size, void *handle) {
+    int fd = HANDLE_TO_FD(handle);
+    u8 *bytes = (u8*)out;
+    while (size) {
+        ssize_t bytes_written = write(fd, bytes, size);
+        if (bytes_written <= 0) {
+#ifndef NDEBUG
+            perror("write");
+            printf("Terminal failure: Unable to write to file.\n");
+#endif
+            close(fd);
+            return false;
+        }
+        bytes += bytes_written;
+        size -= (unsigned long)bytes_written;
+    }
+    return true;
+}
+
+struct PosixThread {
+    os::ThreadProcedure procedure;
+    void *data;
+};
+
+void* posixThreadProc(void *parameter) {
+    PosixThread thread = *(PosixThread*)parameter;
+    free(parameter);
+    thread.procedure(thread.data);
+    return nullptr;
+}
+
+u32 os::getProcessorCount() {
+    long processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+    return processor_count < 1 ? 1 : (u32)processor_count;
+}
+
+bool os::startThread(ThreadProcedure procedure, void *data) {
+    PosixThread *thread = (PosixThread*)malloc(sizeof(PosixThread));
+    if (!thread) return false;
+    thread->procedure = procedure;
+    thread->data = data;
+    pthread_t handle;
+    if (pthread_create(&handle, nullptr, posixThreadProc, thread)) {
+        free(thread);
+        return false;
+    }
+    pthread_detach(handle);
+    return true;
+}
+
+void* os::createSemaphore(u32 initial_count) {
+    sem_t *semaphore = (sem_t*)malloc(sizeof(sem_t));
+    if (semaphore && sem_init(semaphore, 0, initial_count)) {
+        free(semaphore);
+        return nullptr;
+    }
+    return semaphore;
+}
+
+void os::signalSemaphore(void *semaphore, u32 count) {
+    while (count--) sem_post((sem_t*)semaphore);
+}
+
+void os::waitForSemaphore(void *semaphore) {
+    while (sem_wait((sem_t*)semaphore) == -1); // Retry when interrupted by a signal
+}
+
+void initTime() {
+    time::ticks_per_second = 1000000000ULL;
+    time::seconds_per_tick = 1.0 / (f64)(time::ticks_per_second);
+    time::milliseconds_per_tick = 1000.0 * time::seconds_per_tick;
+    time::microseconds_per_tick = 1000.0 * time::milliseconds_per_tick;
+    time::nanoseconds_per_tick  = 1000.0 * time::microseconds_per_tick;
+}
+
+// Tools that embed the engine (benchmarks, harnesses) define SLIM_ENGINE_NO_MAIN and provide their own entry point:
+#ifndef SLIM_ENGINE_NO_MAIN
+SlimEngine *CURRENT_ENGINE;
+
+u16 parseDimension(const char *str, u16 max_value) {
+    long value = strtol(str, nullptr, 10);
+    return (u16)(value < 1 ? 1 : (value > max_value ? max_value : value));
+}
+
+void printUsage(const char *program_name) {
+    printf("Usage: %s [--width W] [--height H] [--frames N] [--click X Y] [--planes] [--threads N] [--profile] [--trace FILE] [--histogram]\n", program_name);
+}
+
+int main(int argc, char **argv) {
+    u16 width = DEFAULT_WIDTH;
+    u16 height = DEFAULT_HEIGHT;
+    u64 frame_count = HEADLESS_DEFAULT__FRAME_COUNT;
+    bool click = false;
+    bool planes = false;
+    const char *trace_path = nullptr;
+    bool histogram = false;
+    i32 click_x = 0;
+    i32 click_y = 0;
+    for (int i = 1; i < argc; i++) {
+        if (     !strcmp(argv[i], "--width" ) && i + 1 < argc) width  = parseDimension(argv[++i], MAX_WIDTH);
+        else if (!strcmp(argv[i], "--height") && i + 1 < argc) height = parseDimension(argv[++i], MAX_HEIGHT);
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc) frame_count = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--planes")) planes = true;
+        else if (!strcmp(argv[i], "--profile")) profiler::enabled = true;
+        else if (!strcmp(argv[i], "--histogram")) histogram = true;
+        else if (!strcmp(argv[i], "--trace") && i + 1 < argc) trace_path = argv[++i];
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) workers::setThreadCount((u32)strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--click" ) && i + 2 < argc) {
+            click = true;
+            click_x = (i32)strtol(argv[++i], nullptr, 10);
+            click_y = (i32)strtol(argv[++i], nullptr, 10);
+        } else {
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+
+    void* window_content_and_canvas_memory = mmap(nullptr, WINDOW_CONTENT_SIZE + CANVAS_SIZE,
+                                                  PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    if (window_content_and_canvas_memory == MAP_FAILED)
+        return -1;
+
+    window::content = (u32*)window_content_and_canvas_memory;
+    window::canvas.pixels = (PixelQuad*)((u8*)window_content_and_canvas_memory + WINDOW_CONTENT_SIZE);
+
+    controls::key_map::ctrl = POSIX_VK_CONTROL;
+    controls::key_map::alt = POSIX_VK_MENU;
+    controls::key_map::shift = POSIX_VK_SHIFT;
+    controls::key_map::space = POSIX_VK_SPACE;
+    controls::key_map::tab = POSIX_VK_TAB;
+    controls::key_map::escape = POSIX_VK_ESCAPE;
+    controls::key_map::left = POSIX_VK_LEFT;
+    controls::key_map::right = POSIX_VK_RIGHT;
+    controls::key_map::up = POSIX_VK_UP;
+    controls::key_map::down = POSIX_VK_DOWN;
+
+    initTime();
+
+    if (planes) window::canvas.setStorage(CanvasStorage::Planes);
+
+    CURRENT_ENGINE = createEngine();
+    if (!CURRENT_ENGINE->is_running)
+        return -1;
+
+    if (trace_path && !trace::begin(trace_path)) {
+        printf("Failed to open trace file \"%s\"\n", trace_path);
+        return -1;
+    }
+
+    CURRENT_ENGINE->resize(width, height);
+
+    if (click) {
+        mouse::setPosition(click_x, click_y);
+        mouse::left_button.down(click_x, click_y);
+        CURRENT_ENGINE->OnMouseButtonDown(mouse::left_button);
+        mouse::left_button.up(click_x, click_y);
+        CURRENT_ENGINE->OnMouseButtonUp(mouse::left_button);
+    }
+
+    u64 frames_drawn = 0;
+    u64 start_ticks = time::getTicks();
+    while (CURRENT_ENGINE->is_running && frames_drawn < frame_count) {
+        CURRENT_ENGINE->OnWindowRedraw();
+        frames_drawn++;
+    }
+    u64 total_ticks = time::getTicks() - start_ticks;
+
+    f64 seconds = (f64)total_ticks * time::seconds_per_tick;
+    printf("resolution: %ux%u\n", (unsigned int)width, (unsigned int)height);
+    printf("frames: %llu\n", (unsigned long long)frames_drawn);
+    printf("seconds: %.6f\n", seconds);
+    printf("frames_per_second: %.2f\n", seconds > 0 ? (f64)frames_drawn / seconds : 0.0);
+    printf("milliseconds_per_frame: %.6f\n", frames_drawn ? (f64)total_ticks * time::milliseconds_per_tick / (f64)frames_drawn : 0.0);
+
+    // Frame time percentiles of the update and render phases:
+    time::FrameHistogram *histograms[2] = {&CURRENT_ENGINE->update_timer.histogram, &CURRENT_ENGINE->render_timer.histogram};
+    const char *phases[2] = {"update", "render"};
+    for (u32 i = 0; i < 2; i++) {
+        time::FrameHistogram &frame_histogram = *histograms[i];
+        frame_histogram.update();
+        printf("%s: p50_us=%u p95_us=%u p99_us=%u max_us=%u over_budget=%llu\n", phases[i],
+               frame_histogram.p50_microseconds, frame_histogram.p95_microseconds,
+               frame_histogram.p99_microseconds, frame_histogram.max_microseconds,
+               (unsigned long long)frame_histogram.over_budget_count);
+        if (histogram) {
+            static char dump[FRAME_HISTOGRAM_BUCKET_COUNT * 32 + 256];
+            frame_histogram.dump(dump, sizeof(dump));
+            printf("%s", dump);
+        }
+    }
+
+    if (trace_path) {
+        bool written = trace::end();
+        printf("trace: %s events=%llu dropped_records=%llu%s\n", trace_path,
+               (unsigned long long)trace::event_count, (unsigned long long)trace::dropped_record_count,
+               written ? "" : " (failed to write)");
+    }
+
+    if (profiler::enabled && profiler::total_frame_count) { // Breakdown of the profiled zones (in tree order)
+        u32 order[PROFILER_MAX_ZONE_COUNT];
+        u32 zone_count = profiler::getZoneOrder(order);
+        for (u32 i = 0; i < zone_count; i++) {
+            u32 zone = order[i];
+            printf("zone: %*s%s milliseconds_per_frame=%.6f calls_per_frame=%.2f\n",
+                   (int)profiler::zone_depths[zone] * 2, "", profiler::zone_names[zone],
+                   (f64)profiler::total_ticks[zone] * time::milliseconds_per_tick / (f64)profiler::total_frame_count,
+                   (f64)profiler::total_calls[zone] / (f64)profiler::total_frame_count);
+        }
+    }
+
+    return 0;
+}
+#endif
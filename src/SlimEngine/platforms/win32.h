@@ -63,8 +63,6 @@ inline bool hasRawMouseInput(LPARAM lParam) {
     );
 }
 
-LARGE_INTEGER performance_counter;
-
 void os::setWindowTitle(char* str) {
     window::title = str;
     SetWindowTextA(window_handle, str);
@@ -80,12 +78,18 @@ void os::setWindowCapture(bool on) {
 }
 
 u64 time::getTicks() {
+    LARGE_INTEGER performance_counter; // Local, as ticks get read from worker threads too (by profiler zones)
     QueryPerformanceCounter(&performance_counter);
     return (u64)performance_counter.QuadPart;
 }
 
+// Any address (as on POSIX), since the memory is asked for more than once (the levels' arenas, the bricks' buffers):
 void* os::getMemory(u64 size) {
-    return VirtualAlloc((LPVOID)MEMORY_BASE, (SIZE_T)size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+    return VirtualAlloc(nullptr, (SIZE_T)size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+}
+
+void os::freeMemory(void *address, u64 size) {
+    VirtualFree(address, 0, MEM_RELEASE);
 }
 
 void os::closeFile(void *handle) {
@@ -154,6 +158,50 @@ bool os::writeToFile(LPVOID out, DWORD size, HANDLE handle) {
     return result != FALSE;
 }
 
+struct Win32Thread {
+    os::ThreadProcedure procedure;
+    void *data;
+};
+
+DWORD WINAPI Win32ThreadProc(LPVOID parameter) {
+    Win32Thread thread = *(Win32Thread*)parameter;
+    HeapFree(GetProcessHeap(), 0, parameter);
+    thread.procedure(thread.data);
+    return 0;
+}
+
+u32 os::getProcessorCount() {
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    return (u32)system_info.dwNumberOfProcessors;
+}
+
+bool os::startThread(ThreadProcedure procedure, void *data) {
+    Win32Thread *thread = (Win32Thread*)HeapAlloc(GetProcessHeap(), 0, sizeof(Win32Thread));
+    if (!thread) return false;
+    thread->procedure = procedure;
+    thread->data = data;
+    HANDLE handle = CreateThread(nullptr, 0, Win32ThreadProc, thread, 0, nullptr);
+    if (!handle) {
+        HeapFree(GetProcessHeap(), 0, thread);
+        return false;
+    }
+    CloseHandle(handle);
+    return true;
+}
+
+void* os::createSemaphore(u32 initial_count) {
+    return CreateSemaphoreA(nullptr, (LONG)initial_count, 0x7FFFFFFF, nullptr);
+}
+
+void os::signalSemaphore(void *semaphore, u32 count) {
+    ReleaseSemaphore((HANDLE)semaphore, (LONG)count, nullptr);
+}
+
+void os::waitForSemaphore(void *semaphore) {
+    WaitForSingleObject((HANDLE)semaphore, INFINITE);
+}
+
 SlimEngine *CURRENT_ENGINE;
 
 LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) {
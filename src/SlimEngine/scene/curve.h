@@ -0,0 +1,131 @@
+#pragma once
+
+#include "../math/mat3.h"
+
+#define CURVE_STEPS 360
+#define CURVE_CACHE_CAPACITY 32
+#define CURVE_CACHE_MAX_STEP_COUNT 1024
+
+// Local-space vertex positions of a curve (one per step), shared by every draw of a curve with the same parameters:
+struct CurveVertices {
+    vec3 *positions{nullptr};
+    u32 step_count{0};
+    u32 last_used{0};
+    CurveType type{CurveType::None};
+    f32 revolution_count{0};
+    f32 thickness{0};
+
+    INLINE bool matches(const Curve &curve, u32 steps) const {
+        return positions &&
+               step_count == steps &&
+               type == curve.type &&
+               revolution_count == curve.revolution_count &&
+               thickness == curve.thickness;
+    }
+
+    void generate(const Curve &curve, u32 steps) {
+        type = curve.type;
+        revolution_count = curve.revolution_count;
+        thickness = curve.thickness;
+        step_count = steps;
+
+        f32 one_over_step_count = 1.0f / (f32)step_count;
+        f32 rotation_step = one_over_step_count * TAU;
+        f32 rotation_step_times_rev_count = rotation_step * (f32)curve.revolution_count;
+
+        if (curve.type == CurveType::Helix)
+            rotation_step = rotation_step_times_rev_count;
+
+        vec3 center_to_orbit;
+        center_to_orbit.x = 1;
+        center_to_orbit.y = center_to_orbit.z = 0;
+
+        vec3 orbit_to_curve;
+        orbit_to_curve.x = curve.thickness;
+        orbit_to_curve.y = orbit_to_curve.z = 0;
+
+        mat3 rotation;
+        rotation.X.x = rotation.Z.z = cosf(rotation_step);
+        rotation.X.z = sinf(rotation_step);
+        rotation.Z.x = -rotation.X.z;
+        rotation.X.y = rotation.Z.y = rotation.Y.x = rotation.Y.z =  0;
+        rotation.Y.y = 1;
+
+        mat3 orbit_to_curve_rotation;
+        if (curve.type == CurveType::Coil) {
+            orbit_to_curve_rotation.X.x = orbit_to_curve_rotation.Y.y = cosf(rotation_step_times_rev_count);
+            orbit_to_curve_rotation.X.y = sinf(rotation_step_times_rev_count);
+            orbit_to_curve_rotation.Y.x = -orbit_to_curve_rotation.X.y;
+            orbit_to_curve_rotation.X.z = orbit_to_curve_rotation.Y.z = orbit_to_curve_rotation.Z.x = orbit_to_curve_rotation.Z.y =  0;
+            orbit_to_curve_rotation.Z.z = 1;
+        }
+
+        mat3 accumulated_orbit_rotation = rotation;
+        vec3 *position = positions;
+        for (u32 i = 0; i < step_count; i++, position++) {
+            center_to_orbit = rotation * center_to_orbit;
+
+            switch (curve.type) {
+                case CurveType::Helix:
+                    *position = center_to_orbit;
+                    position->y -= 1;
+                    break;
+                case CurveType::Coil:
+                    orbit_to_curve = orbit_to_curve_rotation * orbit_to_curve;
+                    *position = accumulated_orbit_rotation * orbit_to_curve;
+                    *position += center_to_orbit;
+                    break;
+                default:
+                    *position = 0.0f;
+                    break;
+            }
+
+            switch (curve.type) {
+                case CurveType::Helix:
+                    center_to_orbit.y += 2 * one_over_step_count;
+                    break;
+                case CurveType::Coil:
+                    accumulated_orbit_rotation *= rotation;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+};
+
+// A fixed set of cached curve vertices keyed by all the parameters that shape the curve (type, revolution count,
+// thickness and step count). Changing any of a curve's parameters simply maps it to a different entry,
+// so stale vertices are never used. When full, the least recently used entry gets regenerated:
+namespace curve_cache {
+    vec3 positions[CURVE_CACHE_CAPACITY][CURVE_CACHE_MAX_STEP_COUNT];
+    CurveVertices entries[CURVE_CACHE_CAPACITY];
+    u32 use_count{0};
+    u32 generated_count{0};
+
+    const CurveVertices& getVertices(const Curve &curve, u32 step_count = CURVE_STEPS) {
+        if (step_count > CURVE_CACHE_MAX_STEP_COUNT) step_count = CURVE_CACHE_MAX_STEP_COUNT;
+
+        CurveVertices *least_recently_used = entries;
+        for (CurveVertices &entry : entries) {
+            if (entry.matches(curve, step_count)) {
+                entry.last_used = ++use_count;
+                return entry;
+            }
+            if (entry.last_used < least_recently_used->last_used)
+                least_recently_used = &entry;
+        }
+
+        CurveVertices &entry = *least_recently_used;
+        entry.positions = positions[&entry - entries];
+        entry.generate(curve, step_count);
+        entry.last_used = ++use_count;
+        generated_count++;
+        return entry;
+    }
+
+    void clear() {
+        for (CurveVertices &entry : entries) entry = CurveVertices{};
+        use_count = 0;
+    }
+}
@@ -1,6 +1,13 @@
 #pragma once
 
 #include "../math/vec3.h"
+#include "../core/workers.h"
+#include "../core/profiler.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SLIM_X86 1
+#include <immintrin.h>
+#endif
 
 struct Pixel {
     f64 depth;
@@ -12,11 +19,8 @@ struct Pixel {
     explicit Pixel(enum ColorID color_id, f32 opacity = 1.0f, f64 depth = 0.0) : Pixel{Color(color_id), opacity, depth} {}
 };
 
-union PixelQuad {
-    Pixel quad[2][2];
-    struct {
-        Pixel TL, TR, BL, BR;
-    };
+struct PixelQuad {
+    Pixel TL, TR, BL, BR;
 
     PixelQuad() noexcept : PixelQuad{
             Pixel{vec3{0}},
@@ -31,83 +35,237 @@ union PixelQuad {
             BL{bottom_left},
             BR{bottom_right}
             {}
+
+    INLINE Pixel& quad(u8 y, u8 x) {
+        return (&TL)[(y << 1) | x];
+    }
 };
 
 #define PIXEL_QUAD_SIZE (sizeof(PixelQuad))
+#define CANVAS_MIN_ROWS_PER_TASK 8
+#define CANVAS_MIN_STREAMED_SPAN 256 // Long fill spans bypass the cache (most of them won't be read again before eviction)
 #define CANVAS_SIZE (MAX_WINDOW_SIZE * PIXEL_QUAD_SIZE)
 
+// Compact planar storage: Each sample gets an f32 depth, a packed (linear) RGB color and an 8-bit coverage.
+// Samples of a pixel are stored consecutively (4 when antialiasing, 1 otherwise), so planes are dense.
+#define CANVAS_PLANES_SAMPLE_SIZE (sizeof(f32) + sizeof(u32) + sizeof(u8))
+#define CANVAS_PLANES_SIZE (MAX_WINDOW_SIZE * 4 * CANVAS_PLANES_SAMPLE_SIZE)
+
+enum class CanvasStorage {
+    PixelQuads = 0,
+    Planes
+};
+
+struct CanvasPlanes {
+    f32 *depths{nullptr};
+    u32 *colors{nullptr};
+    u8 *coverage{nullptr};
+};
+
+// Per-tile dirty tracking:
+// Tiles are square blocks of pixels that get flagged whenever any of their samples is drawn into.
+// Clearing then only refills the tiles drawn into since the last clear (the rest still hold the background),
+// and resolving only resolves drawn tiles, writing the background into the content once for the others.
+#define CANVAS_TILE_SHIFT 5
+#define CANVAS_TILE_SIZE (1 << CANVAS_TILE_SHIFT)
+#define CANVAS_MAX_TILE_COLUMNS ((MAX_WIDTH  + CANVAS_TILE_SIZE - 1) >> CANVAS_TILE_SHIFT)
+#define CANVAS_MAX_TILE_ROWS    ((MAX_HEIGHT + CANVAS_TILE_SIZE - 1) >> CANVAS_TILE_SHIFT)
+#define CANVAS_MAX_TILE_COUNT (CANVAS_MAX_TILE_COLUMNS * CANVAS_MAX_TILE_ROWS)
+
+struct CanvasTiles {
+    u8 drawn[CANVAS_MAX_TILE_COUNT];    // Drawn into since the last clear
+    u8 resolved[CANVAS_MAX_TILE_COUNT]; // Holds resolved pixels in the content (rather than the background)
+    u32 *content{nullptr};              // The content that the resolved flags refer to (null = unknown)
+    u32 content_background{0};
+    Pixel background;                   // What the canvas holds outside of drawn tiles (while cleared)
+    bool cleared{false};
+    u16 columns{0};
+    u16 rows{0};
+    u16 width{0};
+    u16 height{0};
+    u8 sample_shift{CANVAS_TILE_SHIFT};
+    CanvasStorage storage{CanvasStorage::PixelQuads};
+
+    INLINE u32 count() const {
+        return (u32)columns * (u32)rows;
+    }
+};
+
 struct Canvas {
     Dimensions dimensions;
     PixelQuad *pixels{nullptr};
+    CanvasPlanes planes;
+    CanvasStorage storage{CanvasStorage::PixelQuads};
     Pixel background{Black, 0, INFINITY};
+    CanvasTiles tiles;
     bool antialias{true};
 
     explicit Canvas(PixelQuad *pixels) noexcept : pixels{pixels} {}
 
-    void clear() const {
-        fill(background.color,
-             background.opacity,
-             background.depth);
+    // The planes are laid out within the same memory as the pixel quads (which is always large enough):
+    void setStorage(CanvasStorage new_storage) {
+        storage = new_storage;
+        planes.depths   = (f32*)pixels;
+        planes.colors   = (u32*)(planes.depths + MAX_WINDOW_SIZE * 4);
+        planes.coverage =  (u8*)(planes.colors + MAX_WINDOW_SIZE * 4);
+    }
+
+    INLINE u8 samplesPerPixel() const {
+        return antialias ? 4 : 1;
+    }
+
+    INLINE u32 sampleIndex(i32 x, i32 y) const {
+        if (antialias)
+            return ((dimensions.stride * (y >> 1) + (x >> 1)) << 2) | ((y & 1) << 1) | (x & 1);
+
+        return dimensions.stride * y + x;
+    }
+
+    // Re-derive the tile grid when the dimensions or layout changed, returning whether it was still valid:
+    bool updateTiles() {
+        u8 sample_shift = CANVAS_TILE_SHIFT + (antialias ? 1 : 0);
+        if (tiles.width == dimensions.width &&
+            tiles.height == dimensions.height &&
+            tiles.sample_shift == sample_shift &&
+            tiles.storage == storage)
+            return true;
+
+        tiles.width = dimensions.width;
+        tiles.height = dimensions.height;
+        tiles.sample_shift = sample_shift;
+        tiles.storage = storage;
+        tiles.columns = (u16)((dimensions.width  + CANVAS_TILE_SIZE - 1) >> CANVAS_TILE_SHIFT);
+        tiles.rows    = (u16)((dimensions.height + CANVAS_TILE_SIZE - 1) >> CANVAS_TILE_SHIFT);
+        tiles.cleared = false;
+        tiles.content = nullptr;
+        return false;
+    }
+
+    INLINE void markDrawn(i32 x, i32 y) {
+        tiles.drawn[(u32)(y >> tiles.sample_shift) * tiles.columns + (u32)(x >> tiles.sample_shift)] = 1;
+    }
+
+    // Flag the tiles overlapping a (non-empty) rectangle given in pixel (rather than sample) coordinates:
+    INLINE void markDrawnPixels(i32 first_x, i32 end_x, i32 first_y, i32 end_y) {
+        u32 first_column = (u32)first_x >> CANVAS_TILE_SHIFT;
+        u32 column_count = ((u32)(end_x - 1) >> CANVAS_TILE_SHIFT) - first_column + 1;
+        for (u32 row = (u32)first_y >> CANVAS_TILE_SHIFT; row <= (u32)(end_y - 1) >> CANVAS_TILE_SHIFT; row++)
+            memset(tiles.drawn + row * tiles.columns + first_column, 1, column_count);
     }
-    void fill(const Pixel &pixel) const {
+
+    void clear() {
+        if (updateTiles() && tiles.cleared && isSamePixel(tiles.background, background)) {
+            FillJob job{this, background};
+            workers::run(clearDrawnTiles, &job, tiles.rows);
+        } else
+            fill(background);
+    }
+    void fill(const Pixel &pixel) {
         fill(pixel.color, pixel.opacity, pixel.depth);
     }
-    void fill(const vec3 &color, f32 opacity, f64 depth) const {
-        PixelQuad fill_pixel;
-        Pixel fill_sub_pixel;
-        fill_sub_pixel.color = color;
-        fill_sub_pixel.opacity = opacity;
-        fill_sub_pixel.depth = depth;
-        fill_pixel.TL = fill_pixel.TR = fill_pixel.BL = fill_pixel.BR = fill_sub_pixel;
-        for (i32 y = 0; y < dimensions.height; y++)
-            for (i32 x = 0; x < dimensions.width; x++)
-                pixels[dimensions.stride * y + x] = fill_pixel;
-    }
-    INLINE void setPixel(i32 x, i32 y, const Pixel &pixel) const {
+    void fill(const vec3 &color, f32 opacity, f64 depth) {
+        Pixel pixel{color, opacity, depth};
+        FillJob job{this, pixel};
+        workers::run(fillRows, &job, dimensions.height, CANVAS_MIN_ROWS_PER_TASK);
+
+        // Filling with anything other than the background counts as drawing into every tile:
+        updateTiles();
+        tiles.cleared = true;
+        tiles.background = background;
+        memset(tiles.drawn, isSamePixel(pixel, background) ? 0 : 1, tiles.count());
+    }
+    // Fill the pixels within [first_x, end_x) and [first_y, end_y) (already clipped to the canvas), whole rows at a time.
+    // Opaque pixels at depth 0 replace whole spans of samples, skipping blending entirely:
+    void fillRect(i32 first_x, i32 end_x, i32 first_y, i32 end_y, const Pixel &pixel) {
+        if (first_x >= end_x || first_y >= end_y) return;
+
+        markDrawnPixels(first_x, end_x, first_y, end_y);
+
+        if (pixel.opacity == 1 && pixel.depth == 0) {
+            FillJob job{this, pixel};
+            for (i32 y = first_y; y < end_y; y++)
+                job.fillSpan((u32)y, (u32)first_x, (u32)end_x);
+        } else if (storage == CanvasStorage::Planes) {
+            if (antialias) blendRect<CanvasStorage::Planes, true >(first_x, end_x, first_y, end_y, pixel);
+            else           blendRect<CanvasStorage::Planes, false>(first_x, end_x, first_y, end_y, pixel);
+        } else {
+            if (antialias) blendRect<CanvasStorage::PixelQuads, true >(first_x, end_x, first_y, end_y, pixel);
+            else           blendRect<CanvasStorage::PixelQuads, false>(first_x, end_x, first_y, end_y, pixel);
+        }
+    }
+
+    template <CanvasStorage Storage, bool Antialias>
+    void blendRect(i32 first_x, i32 end_x, i32 first_y, i32 end_y, const Pixel &pixel) {
+        i32 scale = Antialias ? 2 : 1;
+        for (i32 y = first_y * scale; y < end_y * scale; y++)
+            for (i32 x = first_x * scale; x < end_x * scale; x++)
+                blendSample<Storage, Antialias>(x, y, pixel);
+    }
+
+    INLINE void setPixel(i32 x, i32 y, const Pixel &pixel) {
         setPixel(x, y, pixel.color, pixel.opacity, pixel.depth);
     }
-    INLINE void setPixel(i32 x, i32 y, const vec3 &color, f32 opacity, f64 depth) const {
-        Pixel *pixel;
-        PixelQuad *pixel_quad;
-        if (antialias) {
-            pixel_quad = pixels + (dimensions.stride * (y >> 1)) + (x >> 1);
-            pixel = &pixel_quad->quad[y & 1][x & 1];
+    INLINE void setPixel(i32 x, i32 y, const vec3 &color, f32 opacity, f64 depth) {
+        if (storage == CanvasStorage::Planes) {
+            if (antialias) writeSample<CanvasStorage::Planes, true >(x, y, color, opacity, depth);
+            else           writeSample<CanvasStorage::Planes, false>(x, y, color, opacity, depth);
         } else {
-            pixel_quad = pixels + (dimensions.stride * y) + x;
-            pixel = &pixel_quad->TL;
+            if (antialias) writeSample<CanvasStorage::PixelQuads, true >(x, y, color, opacity, depth);
+            else           writeSample<CanvasStorage::PixelQuads, false>(x, y, color, opacity, depth);
         }
+    }
 
+    // Sample writes specialized at compile-time for the storage and antialiasing mode:
+    template <CanvasStorage Storage, bool Antialias>
+    INLINE void writeSample(i32 x, i32 y, const vec3 &color, f32 opacity, f64 depth) {
         Pixel new_pixel;
         new_pixel.opacity = opacity;
         new_pixel.color = color;
         new_pixel.depth = depth;
+        if (opacity == 1 && depth == 0)
+            storeSample<Storage, Antialias>(x, y, new_pixel, Storage == CanvasStorage::Planes ? color.toRGBA(0).value : 0);
+        else
+            blendSample<Storage, Antialias>(x, y, new_pixel);
+    }
 
-        if (!(opacity == 1 && depth == 0)) {
-            Pixel background_pixel, foreground_pixel, old_pixel = *pixel;
+    // Replace a sample with an opaque pixel at depth 0 (for planes, given its pre-packed color):
+    template <CanvasStorage Storage, bool Antialias>
+    INLINE void storeSample(i32 x, i32 y, const Pixel &new_pixel, u32 packed_color) {
+        markDrawn(x, y);
+        if (Storage == CanvasStorage::Planes) {
+            u32 index = Antialias ? ((dimensions.stride * (y >> 1) + (x >> 1)) << 2) | ((y & 1) << 1) | (x & 1) : dimensions.stride * y + x;
+            planes.colors[index] = packed_color;
+            planes.coverage[index] = MAX_COLOR_VALUE;
+            planes.depths[index] = 0;
+        } else if (Antialias)
+            pixels[dimensions.stride * (y >> 1) + (x >> 1)].quad(y & 1, x & 1) = new_pixel;
+        else {
+            PixelQuad &pixel_quad = pixels[dimensions.stride * y + x];
+            pixel_quad.TL = pixel_quad.TR = pixel_quad.BL = pixel_quad.BR = new_pixel;
+        }
+    }
 
-            if (old_pixel.depth < new_pixel.depth) {
-                background_pixel = new_pixel;
-                foreground_pixel = old_pixel;
-            } else {
-                background_pixel = old_pixel;
-                foreground_pixel = new_pixel;
-            }
-            if (foreground_pixel.opacity != 1) {
-                f32 one_minus_foreground_opacity = 1.0f - foreground_pixel.opacity;
-                opacity = foreground_pixel.opacity + background_pixel.opacity * one_minus_foreground_opacity;
-                f32 one_over_opacity = opacity == 0 ? 1.0f : 1.0f / opacity;
-                f32 background_factor = background_pixel.opacity * one_over_opacity * one_minus_foreground_opacity;
-                f32 foreground_factor = foreground_pixel.opacity * one_over_opacity;
-
-                pixel->color.r = fast_mul_add(foreground_pixel.color.r, foreground_factor, background_pixel.color.r * background_factor);
-                pixel->color.g = fast_mul_add(foreground_pixel.color.g, foreground_factor, background_pixel.color.g * background_factor);
-                pixel->color.b = fast_mul_add(foreground_pixel.color.b, foreground_factor, background_pixel.color.b * background_factor);
-                pixel->opacity = opacity;
-                pixel->depth   = foreground_pixel.depth;
-            } else *pixel = foreground_pixel;
-        } else *pixel = new_pixel;
-
-        if (!antialias) pixel_quad->BR = pixel_quad->BL = pixel_quad->TR = pixel_quad->TL;
+    template <CanvasStorage Storage, bool Antialias>
+    INLINE void blendSample(i32 x, i32 y, const Pixel &new_pixel) {
+        markDrawn(x, y);
+        if (Storage == CanvasStorage::Planes) {
+            u32 index = Antialias ? ((dimensions.stride * (y >> 1) + (x >> 1)) << 2) | ((y & 1) << 1) | (x & 1) : dimensions.stride * y + x;
+            Pixel pixel{
+                vec3{RGBA{planes.colors[index]}},
+                (f32)planes.coverage[index] * COLOR_COMPONENT_TO_FLOAT,
+                (f64)planes.depths[index]
+            };
+            blend(pixel, new_pixel);
+            planes.colors[index] = pixel.color.toRGBA(0).value;
+            planes.coverage[index] = (u8)(clampedValue(pixel.opacity) * FLOAT_TO_COLOR_COMPONENT);
+            planes.depths[index] = (f32)pixel.depth;
+        } else if (Antialias)
+            blend(pixels[dimensions.stride * (y >> 1) + (x >> 1)].quad(y & 1, x & 1), new_pixel);
+        else {
+            PixelQuad &pixel_quad = pixels[dimensions.stride * y + x];
+            blend(pixel_quad.TL, new_pixel);
+            pixel_quad.BR = pixel_quad.BL = pixel_quad.TR = pixel_quad.TL;
+        }
     }
     INLINE PixelQuad* row(u32 y) const {
         return pixels + y * (u32)dimensions.width;
@@ -115,4 +273,132 @@ struct Canvas {
     INLINE PixelQuad* operator[](u32 y) const {
         return row(y);
     }
+
+    struct FillJob {
+        const Canvas *canvas;
+        PixelQuad pixel;
+        u32 packed_color;
+        f32 packed_depth;
+        u8 packed_coverage;
+
+        FillJob(const Canvas *canvas, const Pixel &fill_pixel) :
+                canvas{canvas},
+                packed_color{fill_pixel.color.toRGBA(0).value},
+                packed_depth{(f32)fill_pixel.depth},
+                packed_coverage{(u8)(clampedValue(fill_pixel.opacity) * FLOAT_TO_COLOR_COMPONENT)} {
+            pixel.TL = pixel.TR = pixel.BL = pixel.BR = fill_pixel;
+        }
+
+        void fillSpan(u32 y, u32 first_x, u32 end_x) const {
+            if (canvas->storage == CanvasStorage::Planes) {
+                u32 samples_per_pixel = canvas->samplesPerPixel();
+                u32 first_sample = (canvas->dimensions.stride * y + first_x) * samples_per_pixel;
+                u32 sample_count = (end_x - first_x) * samples_per_pixel;
+                f32 *sample_depth = canvas->planes.depths + first_sample;
+                u32 *sample_color = canvas->planes.colors + first_sample;
+                const f32 depth = packed_depth;
+                const u32 color = packed_color;
+                u32 i = 0;
+#ifdef SLIM_X86
+                if (end_x - first_x >= CANVAS_MIN_STREAMED_SPAN) {
+                    for (; i < sample_count && ((size_t)(sample_color + i) & 15); i++) {
+                        sample_depth[i] = depth;
+                        sample_color[i] = color;
+                    }
+                    const __m128 depths = _mm_set1_ps(depth);
+                    const __m128i colors = _mm_set1_epi32((int)color);
+                    for (; i + 4 <= sample_count; i += 4) {
+                        _mm_stream_ps(sample_depth + i, depths);
+                        _mm_stream_si128((__m128i*)(sample_color + i), colors);
+                    }
+                    _mm_sfence();
+                }
+#endif
+                for (; i < sample_count; i++) {
+                    sample_depth[i] = depth;
+                    sample_color[i] = color;
+                }
+                memset(canvas->planes.coverage + first_sample, packed_coverage, sample_count);
+            } else {
+                PixelQuad *quad = canvas->pixels + canvas->dimensions.stride * y;
+                u32 x = first_x;
+#ifdef SLIM_X86
+                if (end_x - first_x >= CANVAS_MIN_STREAMED_SPAN && !((size_t)(quad + x) & 15)) {
+                    const __m128i *source = (const __m128i*)&pixel;
+                    __m128i values[PIXEL_QUAD_SIZE / 16];
+                    for (u32 i = 0; i < PIXEL_QUAD_SIZE / 16; i++) values[i] = _mm_loadu_si128(source + i);
+                    for (; x < end_x; x++) {
+                        __m128i *target = (__m128i*)(quad + x);
+                        for (u32 i = 0; i < PIXEL_QUAD_SIZE / 16; i++) _mm_stream_si128(target + i, values[i]);
+                    }
+                    _mm_sfence();
+                }
+#endif
+                for (; x < end_x; x++) quad[x] = pixel;
+            }
+        }
+    };
+
+    static void fillRows(void *data, u32 first_row, u32 end_row) {
+        PROFILE_ZONE("Canvas::fillRows");
+        FillJob &job = *(FillJob*)data;
+        for (u32 y = first_row; y < end_row; y++)
+            job.fillSpan(y, 0, job.canvas->dimensions.width);
+    }
+
+    // Row by row, filling each run of consecutive drawn tiles as a single span:
+    static void clearDrawnTiles(void *data, u32 first_tile_row, u32 end_tile_row) {
+        PROFILE_ZONE("Canvas::clearDrawnTiles");
+        FillJob &job = *(FillJob*)data;
+        Canvas &canvas = *(Canvas*)job.canvas;
+        u32 columns = canvas.tiles.columns;
+        for (u32 tile_row = first_tile_row; tile_row < end_tile_row; tile_row++) {
+            u8 *drawn = canvas.tiles.drawn + tile_row * columns;
+            u32 first_y = tile_row << CANVAS_TILE_SHIFT;
+            u32 end_y = first_y + CANVAS_TILE_SIZE;
+            if (end_y > canvas.dimensions.height) end_y = canvas.dimensions.height;
+            for (u32 y = first_y; y < end_y; y++)
+                for (u32 first_column = 0, end_column; first_column < columns; first_column = end_column) {
+                    for (end_column = first_column + 1; end_column < columns && drawn[end_column] == drawn[first_column]; end_column++);
+                    if (drawn[first_column])
+                        job.fillSpan(y, first_column << CANVAS_TILE_SHIFT, canvas.tileEndX(end_column));
+                }
+            memset(drawn, 0, columns);
+        }
+    }
+
+    INLINE u32 tileEndX(u32 end_column) const {
+        u32 end_x = end_column << CANVAS_TILE_SHIFT;
+        return end_x < dimensions.width ? end_x : dimensions.width;
+    }
+
+    static INLINE bool isSamePixel(const Pixel &a, const Pixel &b) {
+        return a.color == b.color && a.opacity == b.opacity && a.depth == b.depth;
+    }
+
+    // Depth-sorted 'over' compositing of a new pixel with the one already in place:
+    static INLINE void blend(Pixel &pixel, const Pixel &new_pixel) {
+        Pixel background_pixel, foreground_pixel, old_pixel = pixel;
+
+        if (old_pixel.depth < new_pixel.depth) {
+            background_pixel = new_pixel;
+            foreground_pixel = old_pixel;
+        } else {
+            background_pixel = old_pixel;
+            foreground_pixel = new_pixel;
+        }
+        if (foreground_pixel.opacity != 1) {
+            f32 one_minus_foreground_opacity = 1.0f - foreground_pixel.opacity;
+            f32 opacity = foreground_pixel.opacity + background_pixel.opacity * one_minus_foreground_opacity;
+            f32 one_over_opacity = opacity == 0 ? 1.0f : 1.0f / opacity;
+            f32 background_factor = background_pixel.opacity * one_over_opacity * one_minus_foreground_opacity;
+            f32 foreground_factor = foreground_pixel.opacity * one_over_opacity;
+
+            pixel.color.r = fast_mul_add(foreground_pixel.color.r, foreground_factor, background_pixel.color.r * background_factor);
+            pixel.color.g = fast_mul_add(foreground_pixel.color.g, foreground_factor, background_pixel.color.g * background_factor);
+            pixel.color.b = fast_mul_add(foreground_pixel.color.b, foreground_factor, background_pixel.color.b * background_factor);
+            pixel.opacity = opacity;
+            pixel.depth   = foreground_pixel.depth;
+        } else pixel = foreground_pixel;
+    }
 };
\ No newline at end of file
@@ -26,9 +26,12 @@ struct HUDSettings {
                 f32 line_height = 1.0f,
                 ColorID default_color = White) : line_count{line_count}, line_height{line_height}, default_color{default_color} {}
 };
+struct HUDLayer;
+
 struct HUD {
     HUDSettings settings;
     HUDLine *lines{nullptr};
+    HUDLayer *layer{nullptr}; // When set, lines are drawn from their retained composition in the layer
     vec2i position{10, 10};
     bool enabled{true};
 
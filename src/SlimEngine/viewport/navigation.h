@@ -49,12 +49,14 @@ struct Navigation {
         camera.zoom(settings.speed.zoom * mouse::wheel_scroll_amount);
         zoomed = true;
         mouse::wheel_scroll_handled = true;
+        mouse::wheel_scrolled = false;
     }
 
     void dolly(Camera &camera) {
         camera.dolly(settings.speed.dolly * mouse::wheel_scroll_amount);
         moved = true;
         mouse::wheel_scroll_handled = true;
+        mouse::wheel_scrolled = false;
     }
 
     void orient(Camera &camera) {
@@ -0,0 +1,432 @@
+#pragma once
+
+#include "./canvas.h"
+
+#ifdef SLIM_X86
+#ifdef COMPILER_MSVC
+#include <intrin.h>
+#define TARGET_SSE41
+#define TARGET_AVX2
+#else
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// Resolving the canvas into the window content (averaging samples, gamma-correcting and packing to RGBA).
+// The planar canvas storage is resolved by SIMD kernels that are selected at runtime based on the CPU.
+// Samples are weighted using exact integer products so that all kernels produce bit-identical results.
+namespace resolve {
+    enum class Kernel {
+        Scalar = 0,
+        SSE,
+        AVX2
+    };
+
+    static constexpr f32 ANTIALIASED_SCALE = COLOR_COMPONENT_TO_FLOAT * COLOR_COMPONENT_TO_FLOAT * 0.25f;
+    static constexpr f32 ALIASED_SCALE     = COLOR_COMPONENT_TO_FLOAT * COLOR_COMPONENT_TO_FLOAT;
+
+    Kernel detectKernel() {
+#ifdef SLIM_X86
+#ifdef COMPILER_MSVC
+        int info[4];
+        __cpuid(info, 0);
+        int max_function_id = info[0];
+        __cpuid(info, 1);
+        bool has_sse41 = (info[2] & (1 << 19)) != 0;
+        bool has_avx = (info[2] & (1 << 28)) != 0 && (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+        bool has_avx2 = false;
+        if (has_avx && max_function_id >= 7) {
+            __cpuidex(info, 7, 0);
+            has_avx2 = (info[1] & (1 << 5)) != 0;
+        }
+        if (has_avx2) return Kernel::AVX2;
+        if (has_sse41) return Kernel::SSE;
+#else
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return Kernel::AVX2;
+        if (__builtin_cpu_supports("sse4.1")) return Kernel::SSE;
+#endif
+#endif
+        return Kernel::Scalar;
+    }
+
+    Kernel supported_kernel{detectKernel()};
+    Kernel kernel{supported_kernel};
+
+    const char* getKernelName(Kernel k) {
+        switch (k) {
+            case Kernel::AVX2: return "avx2";
+            case Kernel::SSE: return "sse4.1";
+            default: return "scalar";
+        }
+    }
+
+    u32 getBackgroundValue(const Canvas &canvas) {
+        RGBA background_pixel;
+        background_pixel.R = (u8)(canvas.background.color.r * canvas.background.color.r * FLOAT_TO_COLOR_COMPONENT);
+        background_pixel.G = (u8)(canvas.background.color.g * canvas.background.color.g * FLOAT_TO_COLOR_COMPONENT);
+        background_pixel.B = (u8)(canvas.background.color.b * canvas.background.color.b * FLOAT_TO_COLOR_COMPONENT);
+        background_pixel.A = (u8)(canvas.background.opacity * canvas.background.opacity * FLOAT_TO_COLOR_COMPONENT);
+        return background_pixel.value;
+    }
+
+    INLINE u8 gammaCorrected(f32 value) {
+        return (u8)(value > 1.0f ? MAX_COLOR_VALUE : (FLOAT_TO_COLOR_COMPONENT * sqrtf(value)));
+    }
+
+    void quads(const Canvas &canvas, u32 *content, u32 first_pixel, u32 end_pixel) {
+        PixelQuad *src_pixel = canvas.pixels + first_pixel;
+        u32 *trg_value = content + first_pixel;
+        vec3 color;
+        RGBA trg_pixel, background_pixel{getBackgroundValue(canvas)};
+        if (canvas.antialias) {
+            for (u32 i = first_pixel; i < end_pixel; i++, src_pixel++, trg_value++) {
+                if (src_pixel->TL.opacity != 0.0f ||
+                    src_pixel->TR.opacity != 0.0f ||
+                    src_pixel->BL.opacity != 0.0f ||
+                    src_pixel->BR.opacity != 0.0f) {
+                    color = src_pixel->TL.color * (src_pixel->TL.opacity * 0.25f);
+                    color = src_pixel->TR.color.scaleAdd(src_pixel->TR.opacity * 0.25f, color);
+                    color = src_pixel->BL.color.scaleAdd(src_pixel->BL.opacity * 0.25f, color);
+                    color = src_pixel->BR.color.scaleAdd(src_pixel->BR.opacity * 0.25f, color);
+                    trg_pixel.R = gammaCorrected(color.r);
+                    trg_pixel.G = gammaCorrected(color.g);
+                    trg_pixel.B = gammaCorrected(color.b);
+                    trg_pixel.A = (u8)(clampedValue(src_pixel->TL.opacity) * FLOAT_TO_COLOR_COMPONENT);
+                } else trg_pixel = background_pixel;
+                *trg_value = trg_pixel.value;
+            }
+        } else {
+            for (u32 i = first_pixel; i < end_pixel; i++, src_pixel++, trg_value++) {
+                if (src_pixel->TL.depth == INFINITY)
+                    trg_pixel = background_pixel;
+                else {
+                    color = src_pixel->TL.color * src_pixel->TL.opacity;
+                    trg_pixel.R = gammaCorrected(color.r);
+                    trg_pixel.G = gammaCorrected(color.g);
+                    trg_pixel.B = gammaCorrected(color.b);
+                    trg_pixel.A = (u8)(clampedValue(src_pixel->TL.opacity) * FLOAT_TO_COLOR_COMPONENT);
+                }
+                *trg_value = trg_pixel.value;
+            }
+        }
+    }
+
+    void planesScalar(const Canvas &canvas, u32 *content, u32 first_pixel, u32 end_pixel) {
+        u32 *trg_value = content + first_pixel;
+        RGBA trg_pixel, background_pixel{getBackgroundValue(canvas)};
+        RGBA sample_color;
+        u32 r, g, b;
+        if (canvas.antialias) {
+            const u32 *src_color = canvas.planes.colors + first_pixel * 4;
+            const u8 *src_coverage = canvas.planes.coverage + first_pixel * 4;
+            for (u32 i = first_pixel; i < end_pixel; i++, src_color += 4, src_coverage += 4, trg_value++) {
+                if (src_coverage[0] | src_coverage[1] | src_coverage[2] | src_coverage[3]) {
+                    r = g = b = 0;
+                    for (u8 s = 0; s < 4; s++) {
+                        sample_color.value = src_color[s];
+                        r += (u32)sample_color.R * (u32)src_coverage[s];
+                        g += (u32)sample_color.G * (u32)src_coverage[s];
+                        b += (u32)sample_color.B * (u32)src_coverage[s];
+                    }
+                    trg_pixel.R = gammaCorrected((f32)r * ANTIALIASED_SCALE);
+                    trg_pixel.G = gammaCorrected((f32)g * ANTIALIASED_SCALE);
+                    trg_pixel.B = gammaCorrected((f32)b * ANTIALIASED_SCALE);
+                    trg_pixel.A = src_coverage[0];
+                } else trg_pixel = background_pixel;
+                *trg_value = trg_pixel.value;
+            }
+        } else {
+            const u32 *src_color = canvas.planes.colors + first_pixel;
+            const u8 *src_coverage = canvas.planes.coverage + first_pixel;
+            const f32 *src_depth = canvas.planes.depths + first_pixel;
+            for (u32 i = first_pixel; i < end_pixel; i++, src_color++, src_coverage++, src_depth++, trg_value++) {
+                if (*src_depth == INFINITY)
+                    trg_pixel = background_pixel;
+                else {
+                    sample_color.value = *src_color;
+                    trg_pixel.R = gammaCorrected((f32)((u32)sample_color.R * (u32)*src_coverage) * ALIASED_SCALE);
+                    trg_pixel.G = gammaCorrected((f32)((u32)sample_color.G * (u32)*src_coverage) * ALIASED_SCALE);
+                    trg_pixel.B = gammaCorrected((f32)((u32)sample_color.B * (u32)*src_coverage) * ALIASED_SCALE);
+                    trg_pixel.A = *src_coverage;
+                }
+                *trg_value = trg_pixel.value;
+            }
+        }
+    }
+
+#ifdef SLIM_X86
+    TARGET_SSE41 INLINE __m128i gammaCorrected(__m128i weighted_sum, __m128 scale) {
+        __m128 value = _mm_mul_ps(_mm_cvtepi32_ps(weighted_sum), scale);
+        value = _mm_mul_ps(_mm_sqrt_ps(value), _mm_set1_ps(FLOAT_TO_COLOR_COMPONENT));
+        return _mm_cvttps_epi32(_mm_min_ps(value, _mm_set1_ps(FLOAT_TO_COLOR_COMPONENT)));
+    }
+
+    void planesSSE(const Canvas &canvas, u32 *content, u32 first_pixel, u32 end_pixel);
+    void planesAVX2(const Canvas &canvas, u32 *content, u32 first_pixel, u32 end_pixel);
+
+    // 4 pixels per iteration:
+    TARGET_SSE41 void planesSSE(const Canvas &canvas, u32 *content, u32 first_pixel, u32 end_pixel) {
+        const __m128i byte_mask = _mm_set1_epi32(0xFF);
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i background = _mm_set1_epi32((int)getBackgroundValue(canvas));
+        u32 i = first_pixel;
+        if (canvas.antialias) {
+            const __m128 scale = _mm_set1_ps(ANTIALIASED_SCALE);
+            for (; i + 4 <= end_pixel; i += 4) {
+                const u8 *src_coverage = canvas.planes.coverage + i * 4;
+                const u32 *src_color = canvas.planes.colors + i * 4;
+                __m128i coverage = _mm_loadu_si128((const __m128i*)src_coverage);
+                if (_mm_testz_si128(coverage, coverage)) { // Background-only span
+                    _mm_storeu_si128((__m128i*)(content + i), background);
+                    continue;
+                }
+
+                // Per-pixel sample weights (one pixel's 4 samples per vector):
+                __m128i w0 = _mm_cvtepu8_epi32(coverage);
+                __m128i w1 = _mm_cvtepu8_epi32(_mm_srli_si128(coverage, 4));
+                __m128i w2 = _mm_cvtepu8_epi32(_mm_srli_si128(coverage, 8));
+                __m128i w3 = _mm_cvtepu8_epi32(_mm_srli_si128(coverage, 12));
+                __m128i c0 = _mm_loadu_si128((const __m128i*)(src_color + 0));
+                __m128i c1 = _mm_loadu_si128((const __m128i*)(src_color + 4));
+                __m128i c2 = _mm_loadu_si128((const __m128i*)(src_color + 8));
+                __m128i c3 = _mm_loadu_si128((const __m128i*)(src_color + 12));
+
+                __m128i r = _mm_hadd_epi32(
+                        _mm_hadd_epi32(_mm_mullo_epi32(_mm_and_si128(_mm_srli_epi32(c0, 16), byte_mask), w0),
+                                       _mm_mullo_epi32(_mm_and_si128(_mm_srli_epi32(c1, 16), byte_mask), w1)),
+                        _mm_hadd_epi32(_mm_mullo_epi32(_mm_and_si128(_mm_srli_epi32(c2, 16), byte_mask), w2),
+                                       _mm_mullo_epi32(_mm_and_si128(_mm_srli_epi32(c3, 16), byte_mask), w3)));
+                __m128i g = _mm_hadd_epi32(
+                        _mm_hadd_epi32(_mm_mullo_epi32(_mm_and_si128(_mm_srli_epi32(c0, 8), byte_mask), w0),
+                                       _mm_mullo_epi32(_mm_and_si128(_mm_srli_epi32(c1, 8), byte_mask), w1)),
+                        _mm_hadd_epi32(_mm_mullo_epi32(_mm_and_si128(_mm_srli_epi32(c2, 8), byte_mask), w2),
+                                       _mm_mullo_epi32(_mm_and_si128(_mm_srli_epi32(c3, 8), byte_mask), w3)));
+                __m128i b = _mm_hadd_epi32(
+                        _mm_hadd_epi32(_mm_mullo_epi32(_mm_and_si128(c0, byte_mask), w0),
+                                       _mm_mullo_epi32(_mm_and_si128(c1, byte_mask), w1)),
+                        _mm_hadd_epi32(_mm_mullo_epi32(_mm_and_si128(c2, byte_mask), w2),
+                                       _mm_mullo_epi32(_mm_and_si128(c3, byte_mask), w3)));
+
+                __m128i packed = _mm_or_si128(
+                        _mm_or_si128(_mm_slli_epi32(_mm_and_si128(coverage, byte_mask), 24),
+                                     _mm_slli_epi32(gammaCorrected(r, scale), 16)),
+                        _mm_or_si128(_mm_slli_epi32(gammaCorrected(g, scale), 8),
+                                     gammaCorrected(b, scale)));
+                packed = _mm_blendv_epi8(packed, background, _mm_cmpeq_epi32(coverage, zero));
+                _mm_storeu_si128((__m128i*)(content + i), packed);
+            }
+        } else {
+            const __m128 scale = _mm_set1_ps(ALIASED_SCALE);
+            const __m128 infinity = _mm_set1_ps(INFINITY);
+            for (; i + 4 <= end_pixel; i += 4) {
+                __m128 is_background = _mm_cmpeq_ps(_mm_loadu_ps(canvas.planes.depths + i), infinity);
+                if (_mm_movemask_ps(is_background) == 0xF) { // Background-only span
+                    _mm_storeu_si128((__m128i*)(content + i), background);
+                    continue;
+                }
+
+                int coverage_bytes;
+                memcpy(&coverage_bytes, canvas.planes.coverage + i, sizeof(int));
+                __m128i w = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(coverage_bytes));
+                __m128i c = _mm_loadu_si128((const __m128i*)(canvas.planes.colors + i));
+                __m128i r = _mm_mullo_epi32(_mm_and_si128(_mm_srli_epi32(c, 16), byte_mask), w);
+                __m128i g = _mm_mullo_epi32(_mm_and_si128(_mm_srli_epi32(c, 8), byte_mask), w);
+                __m128i b = _mm_mullo_epi32(_mm_and_si128(c, byte_mask), w);
+
+                __m128i packed = _mm_or_si128(
+                        _mm_or_si128(_mm_slli_epi32(w, 24),
+                                     _mm_slli_epi32(gammaCorrected(r, scale), 16)),
+                        _mm_or_si128(_mm_slli_epi32(gammaCorrected(g, scale), 8),
+                                     gammaCorrected(b, scale)));
+                packed = _mm_blendv_epi8(packed, background, _mm_castps_si128(is_background));
+                _mm_storeu_si128((__m128i*)(content + i), packed);
+            }
+        }
+        if (i < end_pixel) planesScalar(canvas, content, i, end_pixel);
+    }
+
+    TARGET_AVX2 INLINE __m256i gammaCorrected(__m256i weighted_sum, __m256 scale) {
+        __m256 value = _mm256_mul_ps(_mm256_cvtepi32_ps(weighted_sum), scale);
+        value = _mm256_mul_ps(_mm256_sqrt_ps(value), _mm256_set1_ps(FLOAT_TO_COLOR_COMPONENT));
+        return _mm256_cvttps_epi32(_mm256_min_ps(value, _mm256_set1_ps(FLOAT_TO_COLOR_COMPONENT)));
+    }
+
+    // Sum each pixel's 4 weighted samples (2 pixels per vector), returning pixel sums in the order 0,2,4,6,1,3,5,7:
+    TARGET_AVX2 INLINE __m256i sumSamples(__m256i p0, __m256i p1, __m256i p2, __m256i p3) {
+        return _mm256_hadd_epi32(_mm256_hadd_epi32(p0, p1), _mm256_hadd_epi32(p2, p3));
+    }
+
+    // 8 pixels per iteration:
+    TARGET_AVX2 void planesAVX2(const Canvas &canvas, u32 *content, u32 first_pixel, u32 end_pixel) {
+        const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i background = _mm256_set1_epi32((int)getBackgroundValue(canvas));
+        u32 i = first_pixel;
+        if (canvas.antialias) {
+            const __m256 scale = _mm256_set1_ps(ANTIALIASED_SCALE);
+            const __m256i pixel_order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+            for (; i + 8 <= end_pixel; i += 8) {
+                const u8 *src_coverage = canvas.planes.coverage + i * 4;
+                const u32 *src_color = canvas.planes.colors + i * 4;
+                __m256i coverage = _mm256_loadu_si256((const __m256i*)src_coverage);
+                if (_mm256_testz_si256(coverage, coverage)) { // Background-only span
+                    _mm256_storeu_si256((__m256i*)(content + i), background);
+                    continue;
+                }
+
+                // Per-sample weights (2 pixels' 4 samples per vector):
+                __m256i w0 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src_coverage + 0)));
+                __m256i w1 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src_coverage + 8)));
+                __m256i w2 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src_coverage + 16)));
+                __m256i w3 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src_coverage + 24)));
+                __m256i c0 = _mm256_loadu_si256((const __m256i*)(src_color + 0));
+                __m256i c1 = _mm256_loadu_si256((const __m256i*)(src_color + 8));
+                __m256i c2 = _mm256_loadu_si256((const __m256i*)(src_color + 16));
+                __m256i c3 = _mm256_loadu_si256((const __m256i*)(src_color + 24));
+
+                __m256i r = sumSamples(
+                        _mm256_mullo_epi32(_mm256_and_si256(_mm256_srli_epi32(c0, 16), byte_mask), w0),
+                        _mm256_mullo_epi32(_mm256_and_si256(_mm256_srli_epi32(c1, 16), byte_mask), w1),
+                        _mm256_mullo_epi32(_mm256_and_si256(_mm256_srli_epi32(c2, 16), byte_mask), w2),
+                        _mm256_mullo_epi32(_mm256_and_si256(_mm256_srli_epi32(c3, 16), byte_mask), w3));
+                __m256i g = sumSamples(
+                        _mm256_mullo_epi32(_mm256_and_si256(_mm256_srli_epi32(c0, 8), byte_mask), w0),
+                        _mm256_mullo_epi32(_mm256_and_si256(_mm256_srli_epi32(c1, 8), byte_mask), w1),
+                        _mm256_mullo_epi32(_mm256_and_si256(_mm256_srli_epi32(c2, 8), byte_mask), w2),
+                        _mm256_mullo_epi32(_mm256_and_si256(_mm256_srli_epi32(c3, 8), byte_mask), w3));
+                __m256i b = sumSamples(
+                        _mm256_mullo_epi32(_mm256_and_si256(c0, byte_mask), w0),
+                        _mm256_mullo_epi32(_mm256_and_si256(c1, byte_mask), w1),
+                        _mm256_mullo_epi32(_mm256_and_si256(c2, byte_mask), w2),
+                        _mm256_mullo_epi32(_mm256_and_si256(c3, byte_mask), w3));
+
+                __m256i rgb = _mm256_or_si256(
+                        _mm256_slli_epi32(gammaCorrected(r, scale), 16),
+                        _mm256_or_si256(_mm256_slli_epi32(gammaCorrected(g, scale), 8),
+                                        gammaCorrected(b, scale)));
+                __m256i packed = _mm256_or_si256(
+                        _mm256_permutevar8x32_epi32(rgb, pixel_order),
+                        _mm256_slli_epi32(_mm256_and_si256(coverage, byte_mask), 24));
+                packed = _mm256_blendv_epi8(packed, background, _mm256_cmpeq_epi32(coverage, zero));
+                _mm256_storeu_si256((__m256i*)(content + i), packed);
+            }
+        } else {
+            const __m256 scale = _mm256_set1_ps(ALIASED_SCALE);
+            const __m256 infinity = _mm256_set1_ps(INFINITY);
+            for (; i + 8 <= end_pixel; i += 8) {
+                __m256 is_background = _mm256_cmp_ps(_mm256_loadu_ps(canvas.planes.depths + i), infinity, _CMP_EQ_OQ);
+                if (_mm256_movemask_ps(is_background) == 0xFF) { // Background-only span
+                    _mm256_storeu_si256((__m256i*)(content + i), background);
+                    continue;
+                }
+
+                __m256i w = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(canvas.planes.coverage + i)));
+                __m256i c = _mm256_loadu_si256((const __m256i*)(canvas.planes.colors + i));
+                __m256i r = _mm256_mullo_epi32(_mm256_and_si256(_mm256_srli_epi32(c, 16), byte_mask), w);
+                __m256i g = _mm256_mullo_epi32(_mm256_and_si256(_mm256_srli_epi32(c, 8), byte_mask), w);
+                __m256i b = _mm256_mullo_epi32(_mm256_and_si256(c, byte_mask), w);
+
+                __m256i packed = _mm256_or_si256(
+                        _mm256_or_si256(_mm256_slli_epi32(w, 24),
+                                        _mm256_slli_epi32(gammaCorrected(r, scale), 16)),
+                        _mm256_or_si256(_mm256_slli_epi32(gammaCorrected(g, scale), 8),
+                                        gammaCorrected(b, scale)));
+                packed = _mm256_blendv_epi8(packed, background, _mm256_castps_si256(is_background));
+                _mm256_storeu_si256((__m256i*)(content + i), packed);
+            }
+        }
+        if (i < end_pixel) planesScalar(canvas, content, i, end_pixel);
+    }
+#endif
+
+    void planes(const Canvas &canvas, u32 *content, u32 first_pixel, u32 end_pixel, Kernel planes_kernel = kernel) {
+        switch (planes_kernel) {
+#ifdef SLIM_X86
+            case Kernel::AVX2: planesAVX2(canvas, content, first_pixel, end_pixel); break;
+            case Kernel::SSE : planesSSE( canvas, content, first_pixel, end_pixel); break;
+#endif
+            default: planesScalar(canvas, content, first_pixel, end_pixel);
+        }
+    }
+
+    // Resolve the pixels in the range [first_pixel, end_pixel) of the canvas into the content:
+    void run(const Canvas &canvas, u32 *content, u32 first_pixel, u32 end_pixel) {
+        if (canvas.storage == CanvasStorage::Planes)
+            planes(canvas, content, first_pixel, end_pixel);
+        else
+            quads(canvas, content, first_pixel, end_pixel);
+    }
+
+    struct Job {
+        Canvas *canvas;
+        u32 *content;
+        u32 background;
+    };
+
+    void runRows(void *data, u32 first_row, u32 end_row) {
+        PROFILE_ZONE("resolve::runRows");
+        Job &job = *(Job*)data;
+        u32 width = job.canvas->dimensions.width;
+        run(*job.canvas, job.content, first_row * width, end_row * width);
+    }
+
+    enum TileAction : u8 {
+        SkipTile = 0,
+        ResolveTile,
+        ClearTile
+    };
+
+    // Row by row, handling each run of consecutive tiles that need the same action as a single span:
+    void runTiles(void *data, u32 first_tile_row, u32 end_tile_row) {
+        PROFILE_ZONE("resolve::runTiles");
+        Job &job = *(Job*)data;
+        Canvas &canvas = *job.canvas;
+        u32 width = canvas.dimensions.width;
+        u32 columns = canvas.tiles.columns;
+        u8 actions[CANVAS_MAX_TILE_COLUMNS];
+        for (u32 tile_row = first_tile_row; tile_row < end_tile_row; tile_row++) {
+            u8 *drawn = canvas.tiles.drawn + tile_row * columns;
+            u8 *resolved = canvas.tiles.resolved + tile_row * columns;
+            for (u32 column = 0; column < columns; column++) {
+                actions[column] = drawn[column] ? ResolveTile : (resolved[column] ? ClearTile : SkipTile);
+                resolved[column] = drawn[column];
+            }
+
+            u32 first_y = tile_row << CANVAS_TILE_SHIFT;
+            u32 end_y = first_y + CANVAS_TILE_SIZE;
+            if (end_y > canvas.dimensions.height) end_y = canvas.dimensions.height;
+            for (u32 y = first_y; y < end_y; y++)
+                for (u32 first_column = 0, end_column; first_column < columns; first_column = end_column) {
+                    for (end_column = first_column + 1; end_column < columns && actions[end_column] == actions[first_column]; end_column++);
+                    if (actions[first_column] == SkipTile) continue;
+
+                    u32 first_pixel = y * width + (first_column << CANVAS_TILE_SHIFT);
+                    u32 end_pixel = y * width + canvas.tileEndX(end_column);
+                    if (actions[first_column] == ResolveTile)
+                        run(canvas, job.content, first_pixel, end_pixel);
+                    else
+                        for (u32 i = first_pixel; i < end_pixel; i++) job.content[i] = job.background;
+                }
+        }
+    }
+
+    // Resolve the whole canvas into the content, split into bands across the worker threads.
+    // Only tiles drawn into are resolved when the canvas is known to hold the background everywhere else:
+    void runAll(Canvas &canvas, u32 *content) {
+        Job job{&canvas, content, getBackgroundValue(canvas)};
+        if (!canvas.updateTiles() || !canvas.tiles.cleared) {
+            canvas.tiles.content = nullptr;
+            workers::run(runRows, &job, canvas.dimensions.height, CANVAS_MIN_ROWS_PER_TASK);
+            return;
+        }
+
+        if (canvas.tiles.content != content || canvas.tiles.content_background != job.background) {
+            canvas.tiles.content = content;
+            canvas.tiles.content_background = job.background;
+            memset(canvas.tiles.resolved, 1, canvas.tiles.count());
+        }
+        workers::run(runTiles, &job, canvas.tiles.rows);
+    }
+}
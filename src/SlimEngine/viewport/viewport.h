@@ -6,9 +6,12 @@
 #include "./canvas.h"
 #include "../core/ray.h"
 
+struct LineBatch;
+
 struct Viewport {
     Canvas &canvas;
     Camera *camera{nullptr};
+    LineBatch *line_batch{nullptr}; // When set, edges are submitted into the batch instead of being drawn immediately
     Frustum frustum;
     Dimensions dimensions;
     Navigation navigation;
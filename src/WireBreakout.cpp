@@ -1,33 +1,22 @@
 #include "./SlimEngine/draw/rectangle.h"
 #include "./SlimEngine/draw/curve.h"
 #include "./SlimEngine/draw/hud.h"
+#include "./SlimEngine/draw/profiler.h"
 #include "./SlimEngine/app.h"
 
 #include "./GameLib/game.hpp"
+#include "./GameLib/maps.hpp"
 
 struct WireBreakout : SlimEngine {
-    // Maps/Levels for the game:
-    char *map1{(char*)""
-                      "  ~  " "\n"
-                      "#= =#" "\n"
-                      "=~  =" "\n"
-                      "=---="
-    };
-    char *map2{(char*)""
-                      "     " "\n"
-                      "#-==*" "\n"
-                      "~  -=" "\n"
-                      "=~  =" "\n"
-                      "-=~ #"
-    };
-
-    // Statically sized buffer for the bricks
-    Brick bricks[64];
+    // Levels of the game (each one stores its own bricks, sized to its map):
+    Level level01{GameMaps::level01};
+    Level level02{GameMaps::level02};
 
-    Level level01{map1, bricks};
-    Level level02{map2, bricks};
+    // Per-instance buffers for drawing the bricks (sized to the largest level):
+    Transform *brick_transforms;
+    vec3 *brick_colors;
 
-    Game game{&level01, 2};
+    Game game{&level01, GameMaps::levels_count};
 
     // Viewport and Cameras:
     Camera game_camera{
@@ -41,6 +30,7 @@ struct WireBreakout : SlimEngine {
     };
     Camera editor_camera;
     Viewport viewport{window::canvas, &game_camera};
+    LineBatch line_batch;
 
     // HUD:
     HUDLine Lives{ (char*)"Lives : "};
@@ -51,6 +41,8 @@ struct WireBreakout : SlimEngine {
             Green
     };
     HUD hud{hud_settings, &Lives};
+    HUDLayer hud_layer;
+    ProfilerOverlay profiler_overlay;
     RectI progress_bar{200, 300, 10, 35};
     const f32 progress_bar_width{(f32)(progress_bar.right - progress_bar.left)};
     const i32 progress_bar_padding = 35;
@@ -64,11 +56,23 @@ struct WireBreakout : SlimEngine {
     f32 opacity = 0.5f;
     u8 line_width = 0;
 
+    // Simulation:
+    const u16 steps_per_second = 240;
+
     WireBreakout() {
+        update_timer.setFixedStepRate(steps_per_second);
         viewport.navigation.settings.max_velocity *= 10;
         viewport.navigation.settings.acceleration *= 10;
         viewport.frustum.projection.type = Frustum::ProjectionType::Orthographic;
         viewport.updateProjection();
+        viewport.line_batch = &line_batch;
+        hud.layer = &hud_layer;
+        curve_lod::enabled = true;
+
+        u32 max_bricks_count = level01.bricks.count > level02.bricks.count ? level01.bricks.count : level02.bricks.count;
+        memory::MonotonicAllocator memory_allocator{(sizeof(Transform) + sizeof(vec3)) * max_bricks_count};
+        brick_transforms = (Transform*)memory_allocator.allocate(sizeof(Transform) * max_bricks_count);
+        brick_colors = (vec3*)memory_allocator.allocate(sizeof(vec3) * max_bricks_count);
     }
 
     void OnRender() override {
@@ -87,12 +91,15 @@ struct WireBreakout : SlimEngine {
             draw(s.rect, viewport, s.border_color);
             draw(q.rect, viewport, q.border_color);
 
-            drawText(t.text.char_ptr, t.text_position.x, t.text_position.y, viewport, t.color, 1);
-            drawText(s.text.char_ptr, s.text_position.x, s.text_position.y, viewport, s.color, 1);
-            drawText(q.text.char_ptr, q.text_position.x, q.text_position.y, viewport, q.color, 1);
+            drawCachedText(t.text.char_ptr, t.text_position.x, t.text_position.y, viewport, t.color, 1);
+            drawCachedText(s.text.char_ptr, s.text_position.x, s.text_position.y, viewport, s.color, 1);
+            drawCachedText(q.text.char_ptr, q.text_position.x, q.text_position.y, viewport, q.color, 1);
         } else {
             Level &level = *game.current_level;
 
+            // Interpolate between the last 2 fixed simulation steps (unless the simulation is paused):
+            f32 t = game.is_paused ? 1.0f : update_timer.interpolation_factor;
+
             // Draw Bounds:
             transform = default_transform;
             transform.position.x = level.scale.x + 1;
@@ -107,31 +114,36 @@ struct WireBreakout : SlimEngine {
             transform.scale.x = level.scale.x + 2;
             draw(helix, transform, viewport, level.bounds_color, opacity, line_width);
 
-            // Draw Level:
-            transform = default_transform;
-            transform.scale.x = level.scale.x + 2;
-            for (u32 i = 0; i < level.bricks_count; i++) {
-                Brick &brick = level.bricks[i];
-                if (brick.is_broken()) continue;
-                transform.position.x = brick.position.x;
-                transform.position.y = brick.position.y;
-                transform.scale.x = brick.scale_x;
-                draw(helix, transform, viewport, Color(brick.color_id), opacity, line_width);
-            }
+            // Draw Level (all remaining bricks as instances of the same curve, skipping over the broken ones by their bits):
+            BrickArrays &bricks = level.bricks;
+            u32 brick_instance_count = 0;
+            for (u32 word = 0; word < BrickArrays::getWordCount(bricks.count); word++)
+                for (u64 alive = bricks.alive[word]; alive; alive &= alive - 1) {
+                    u32 i = word * 64 + lowestBitIndex(alive);
+                    Transform &brick_transform = brick_transforms[brick_instance_count];
+                    brick_transform = default_transform;
+                    brick_transform.position.x = lerp(bricks.previous_positions_x[i], bricks.positions_x[i], t);
+                    brick_transform.position.y = bricks.positions_y[i];
+                    brick_transform.scale.x = bricks.scales_x[i];
+                    brick_colors[brick_instance_count++] = Color(bricks.color_ids[i]);
+                }
+            draw(helix, brick_transforms, brick_instance_count, viewport, brick_colors, Color(White), opacity, line_width);
 
             // Draw Paddle:
             transform = default_transform;
             transform.scale.x = game.paddle.scale_x;
-            transform.position.x = game.paddle.position.x;
+            transform.position.x = lerp(game.paddle.previous_position_x, game.paddle.position.x, t);
             draw(helix, transform, viewport, Color(game.paddle.color_id), opacity, line_width);
 
             // Draw Ball:
             transform = default_transform;
             transform.scale = game.ball.radius;
             transform.rotation = ball_orientation;
-            transform.position.x = game.ball.position.x;
-            transform.position.y = game.ball.position.y;
+            vec2 ball_position = lerp(game.ball.previous_position, game.ball.position, t);
+            transform.position.x = ball_position.x;
+            transform.position.y = ball_position.y;
             draw(helix, transform, viewport, Color(game.ball.color_id), opacity, line_width);
+            line_batch.flush();
 
             // Draw HUD:
             Lives.value = (i32)game.lives;
@@ -156,9 +168,11 @@ struct WireBreakout : SlimEngine {
                 GameUI::TextBox &t = GameUI::game_paused_text;
                 t.setRelativePosition(viewport.dimensions.width,
                                       viewport.dimensions.height);
-                drawText(t.text.char_ptr, t.text_position.x, t.text_position.y, viewport, t.color, 1);
+                drawCachedText(t.text.char_ptr, t.text_position.x, t.text_position.y, viewport, t.color, 1);
             }
         }
+
+        if (profiler::enabled) draw(profiler_overlay, viewport, &update_timer, &render_timer);
     }
     void OnWindowResize(u16 width, u16 height) override {
         viewport.updateDimensions(width, height);
@@ -192,6 +206,12 @@ struct WireBreakout : SlimEngine {
             is_running = false;
             return;
         }
+        if (key == controls::key_map::tab && is_pressed) { // Toggle the profiler (and its overlay)
+            profiler::enabled = !profiler::enabled;
+            profiler::resetTotals();
+            update_timer.histogram.reset();
+            render_timer.histogram.reset();
+        }
         if (key == controls::key_map::space && is_pressed && !mouse::is_captured) {
             // Toggle game pausing mode, switching cameras and projection types:
             game.is_paused = !game.is_paused;